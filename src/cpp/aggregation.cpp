@@ -0,0 +1,208 @@
+#include "aggregation.h"
+#include "columnar.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace Aggregation {
+    const Columnar::Schema TIMESTAMP_SCHEMA = {{"timestamp", 8, Columnar::Codec::DeltaOfDelta}};
+
+    void Result::merge(const Result& other) {
+        if (other.count == 0) {
+            return;
+        }
+        if (count == 0) {
+            min = other.min;
+            max = other.max;
+        } else {
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+        }
+        count += other.count;
+        sum += other.sum;
+    }
+
+    // Aggregate elements [first, last) of the run start, start + step, ...
+    // without expanding it: the ends bound min/max and the sum is arithmetic
+    Result aggregateRun(int64_t start, int64_t step, uint64_t first, uint64_t last) {
+        Result result;
+        if (first >= last) {
+            return result;
+        }
+
+        uint64_t n = last - first;
+        int64_t firstValue = start + step * static_cast<int64_t>(first);
+        int64_t lastValue = start + step * static_cast<int64_t>(last - 1);
+
+        result.count = n;
+        result.min = std::min(firstValue, lastValue);
+        result.max = std::max(firstValue, lastValue);
+        result.sum = static_cast<int64_t>(n) * firstValue +
+                     step * static_cast<int64_t>(n * (n - 1) / 2);
+        return result;
+    }
+
+    SeriesStore::SeriesStore(size_t samplesPerBlock) :
+        samplesPerBlock(std::max<size_t>(1, samplesPerBlock)) {}
+
+    bool SeriesStore::append(uint64_t timestamp, int64_t value) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+
+        uint64_t latest = 0;
+        bool hasLatest = false;
+        if (!pendingTimestamps.empty()) {
+            latest = pendingTimestamps.back();
+            hasLatest = true;
+        } else if (!blocks.empty()) {
+            latest = blocks.back().lastTimestamp;
+            hasLatest = true;
+        }
+        if (hasLatest && timestamp < latest) {
+            return false;
+        }
+
+        pendingTimestamps.push_back(timestamp);
+        pendingValues.push_back(value);
+
+        if (pendingTimestamps.size() >= samplesPerBlock) {
+            seal();
+        }
+        return true;
+    }
+
+    void SeriesStore::seal() {
+        Block block;
+        block.firstTimestamp = pendingTimestamps.front();
+        block.lastTimestamp = pendingTimestamps.back();
+
+        std::string packed(pendingTimestamps.size() * sizeof(uint64_t), '\0');
+        std::memcpy(&packed[0], pendingTimestamps.data(), packed.size());
+        block.timestamps = Columnar::compress(packed, TIMESTAMP_SCHEMA).first;
+
+        // Split the values into runs of constant step
+        const std::vector<int64_t>& values = pendingValues;
+        int64_t previous = 0;
+        size_t i = 0;
+        while (i < values.size()) {
+            int64_t step = 0;
+            size_t length = 1;
+            if (i + 1 < values.size()) {
+                step = values[i + 1] - values[i];
+                length = 2;
+                while (i + length < values.size() && values[i + length] - values[i + length - 1] == step) {
+                    length++;
+                }
+            }
+
+            Columnar::putVarint(block.runs, length);
+            Columnar::putVarint(block.runs, Columnar::zigzag(static_cast<uint64_t>(values[i] - previous)));
+            Columnar::putVarint(block.runs, Columnar::zigzag(static_cast<uint64_t>(step)));
+
+            block.summary.merge(aggregateRun(values[i], step, 0, length));
+            previous = values[i + length - 1];
+            i += length;
+        }
+
+        blocks.push_back(std::move(block));
+        pendingTimestamps.clear();
+        pendingValues.clear();
+    }
+
+    // Partially covered block: decode its timestamps to find the index
+    // range, then walk the runs and aggregate the overlapping part of each
+    Result SeriesStore::queryBlock(const Block& block, uint64_t from, uint64_t to) const {
+        Result result;
+
+        std::string packed = Columnar::decompress(block.timestamps, TIMESTAMP_SCHEMA);
+        std::vector<uint64_t> timestamps(packed.size() / sizeof(uint64_t));
+        std::memcpy(timestamps.data(), packed.data(), timestamps.size() * sizeof(uint64_t));
+
+        uint64_t first = std::lower_bound(timestamps.begin(), timestamps.end(), from) - timestamps.begin();
+        uint64_t last = std::upper_bound(timestamps.begin(), timestamps.end(), to) - timestamps.begin();
+
+        size_t pos = 0;
+        uint64_t index = 0;
+        int64_t previous = 0;
+        while (index < last && pos < block.runs.size()) {
+            uint64_t length = 0;
+            uint64_t startDelta = 0;
+            uint64_t step = 0;
+            if (!Columnar::getVarint(block.runs, pos, length) ||
+                !Columnar::getVarint(block.runs, pos, startDelta) ||
+                !Columnar::getVarint(block.runs, pos, step) || length == 0) {
+                break;
+            }
+
+            int64_t start = previous + static_cast<int64_t>(Columnar::unzigzag(startDelta));
+            int64_t runStep = static_cast<int64_t>(Columnar::unzigzag(step));
+
+            uint64_t runFirst = std::max(first, index) - index;
+            uint64_t runLast = std::min(last, index + length) - index;
+            if (first < index + length) {
+                result.merge(aggregateRun(start, runStep, runFirst, runLast));
+            }
+
+            previous = start + runStep * static_cast<int64_t>(length - 1);
+            index += length;
+        }
+
+        return result;
+    }
+
+    Result SeriesStore::query(uint64_t from, uint64_t to) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        Result result;
+        if (from > to) {
+            return result;
+        }
+
+        // Blocks are in time order, so their last timestamps are sorted
+        auto it = std::lower_bound(blocks.begin(), blocks.end(), from,
+            [](const Block& block, uint64_t timestamp) {
+                return block.lastTimestamp < timestamp;
+            });
+
+        for (; it != blocks.end() && it->firstTimestamp <= to; ++it) {
+            if (from <= it->firstTimestamp && it->lastTimestamp <= to) {
+                result.merge(it->summary);
+                result.blocksFromSummary++;
+            } else {
+                result.merge(queryBlock(*it, from, to));
+                result.blocksDecoded++;
+            }
+        }
+
+        // The open block is still raw
+        for (size_t i = 0; i < pendingTimestamps.size(); i++) {
+            if (pendingTimestamps[i] >= from && pendingTimestamps[i] <= to) {
+                result.merge(aggregateRun(pendingValues[i], 0, 0, 1));
+            }
+        }
+
+        return result;
+    }
+
+    size_t SeriesStore::sampleCount() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        size_t count = pendingTimestamps.size();
+        for (const Block& block : blocks) {
+            count += block.summary.count;
+        }
+        return count;
+    }
+
+    size_t SeriesStore::blockCount() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return blocks.size();
+    }
+
+    size_t SeriesStore::compressedBytes() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        size_t bytes = 0;
+        for (const Block& block : blocks) {
+            bytes += block.timestamps.size() + block.runs.size() + sizeof(Block);
+        }
+        return bytes;
+    }
+}
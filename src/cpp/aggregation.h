@@ -0,0 +1,74 @@
+#ifndef AGGREGATION_H
+#define AGGREGATION_H
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Aggregation queries over compressed telemetry.
+//
+// A series of (timestamp, value) samples is stored in sealed blocks. Each
+// block keeps its timestamps delta-of-delta coded (Columnar), its values as
+// runs of constant step ("value, step, length" - plain RLE when the step is
+// zero) and a summary of count/min/max/sum. A range query answers blocks
+// that lie entirely inside the range from their summaries; only the two
+// boundary blocks have their timestamps decoded, and even there the values
+// are aggregated per run in closed form rather than expanded.
+//
+// Values are integers; store sensor readings in fixed point (for example
+// hundredths of a degree).
+namespace Aggregation {
+    struct Result {
+        uint64_t count = 0;
+        int64_t min = 0;
+        int64_t max = 0;
+        int64_t sum = 0;
+
+        // Work done to answer the query
+        size_t blocksFromSummary = 0;
+        size_t blocksDecoded = 0;
+
+        double average() const { return count ? static_cast<double>(sum) / count : 0.0; }
+        void merge(const Result& other);
+    };
+
+    // Appends and queries may run concurrently from different threads
+    class SeriesStore {
+    public:
+        explicit SeriesStore(size_t samplesPerBlock = 1024);
+
+        // Timestamps must not decrease; returns false for an out-of-order sample
+        bool append(uint64_t timestamp, int64_t value);
+
+        // min/max/sum/count over samples with from <= timestamp <= to
+        Result query(uint64_t from, uint64_t to) const;
+
+        size_t sampleCount() const;
+        size_t blockCount() const;
+        size_t compressedBytes() const;
+
+    private:
+        struct Block {
+            uint64_t firstTimestamp;
+            uint64_t lastTimestamp;
+            Result summary;
+            std::string timestamps;  // Columnar delta-of-delta
+            std::string runs;        // varint length, zigzag start delta, zigzag step
+        };
+
+        void seal();
+        Result queryBlock(const Block& block, uint64_t from, uint64_t to) const;
+
+        size_t samplesPerBlock;
+        std::vector<Block> blocks;
+
+        // The open block, kept raw until it fills
+        std::vector<uint64_t> pendingTimestamps;
+        std::vector<int64_t> pendingValues;
+
+        mutable std::shared_mutex mutex;
+    };
+}
+
+#endif // AGGREGATION_H
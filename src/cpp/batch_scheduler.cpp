@@ -0,0 +1,180 @@
+#include "batch_scheduler.h"
+
+#include <chrono>
+
+BatchScheduler::BatchScheduler(Compressor compressor, FlushHandler onFlush, uint64_t nowMs) :
+    compressor(std::move(compressor)),
+    onFlush(std::move(onFlush)),
+    wheel(nowMs) {
+    // Defaults follow how each class reports: sensors trickle small
+    // readings and tolerate a second of delay, cameras send bulk data that
+    // fills a batch quickly and should not be held back
+    setPolicy(Dictionary::DeviceClass::Sensor, {4 * 1024, 1000});
+    setPolicy(Dictionary::DeviceClass::Controller, {2 * 1024, 200});
+    setPolicy(Dictionary::DeviceClass::Gateway, {64 * 1024, 100});
+    setPolicy(Dictionary::DeviceClass::Camera, {256 * 1024, 50});
+}
+
+uint64_t BatchScheduler::currentTimeMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void BatchScheduler::setPolicy(Dictionary::DeviceClass deviceClass, const Policy& policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policies[static_cast<size_t>(deviceClass)] = policy;
+}
+
+BatchScheduler::Policy BatchScheduler::policy(Dictionary::DeviceClass deviceClass) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return policies[static_cast<size_t>(deviceClass)];
+}
+
+void BatchScheduler::setMaxQueuedBytes(size_t maxQueuedBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->maxQueuedBytes = maxQueuedBytes;
+}
+
+size_t BatchScheduler::deviceCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return devices.size();
+}
+
+size_t BatchScheduler::queuedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return readyBytes;
+}
+
+void BatchScheduler::enqueue(uint32_t slot) {
+    ready.push_back(take(slot));
+    readyBytes += ready.back().buffer.size();
+}
+
+BatchScheduler::Pending BatchScheduler::take(uint32_t slot) {
+    Device& device = devices[slot];
+    wheel.cancel(slot);
+
+    Pending pending{device.id, device.deviceClass, std::move(device.buffer), device.frameCount};
+    device.buffer.clear();
+    device.frameCount = 0;
+    return pending;
+}
+
+bool BatchScheduler::submit(const std::string& deviceId, Dictionary::DeviceClass deviceClass,
+                            const std::string& frame, uint64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Fire overdue deadlines first so the timing wheel never lags
+    wheel.advance(nowMs, [this](uint32_t slot) {
+        enqueue(slot);
+    });
+
+    // Shed load rather than queue without bound when poll() falls behind
+    if (readyBytes >= maxQueuedBytes) {
+        return false;
+    }
+
+    auto it = slots.find(deviceId);
+    uint32_t slot;
+    if (it == slots.end()) {
+        slot = static_cast<uint32_t>(devices.size());
+        slots.emplace(deviceId, slot);
+        devices.emplace_back();
+        devices.back().id = deviceId;
+    } else {
+        slot = it->second;
+    }
+
+    Device& device = devices[slot];
+    device.deviceClass = deviceClass;
+    const Policy& policy = policies[static_cast<size_t>(deviceClass)];
+
+    // Varint length prefix
+    size_t length = frame.size();
+    while (length >= 0x80) {
+        device.buffer.push_back(static_cast<char>((length & 0x7F) | 0x80));
+        length >>= 7;
+    }
+    device.buffer.push_back(static_cast<char>(length));
+    device.buffer += frame;
+    device.frameCount++;
+
+    if (device.buffer.size() >= policy.maxBytes) {
+        enqueue(slot);
+    } else if (device.frameCount == 1) {
+        // The first frame of a batch starts its latency deadline
+        wheel.schedule(slot, nowMs + policy.maxDelayMs);
+    }
+    return true;
+}
+
+void BatchScheduler::poll(uint64_t nowMs) {
+    std::vector<Pending> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(ready);
+        readyBytes = 0;
+        wheel.advance(nowMs, [this, &pending](uint32_t slot) {
+            pending.push_back(take(slot));
+        });
+    }
+
+    compressAndFlush(pending);
+}
+
+void BatchScheduler::flushAll() {
+    std::vector<Pending> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(ready);
+        readyBytes = 0;
+        for (uint32_t slot = 0; slot < devices.size(); slot++) {
+            if (devices[slot].frameCount > 0) {
+                pending.push_back(take(slot));
+            }
+        }
+    }
+
+    compressAndFlush(pending);
+}
+
+// Compression runs outside the lock so other devices keep submitting
+void BatchScheduler::compressAndFlush(std::vector<Pending>& pending) {
+    for (Pending& batch : pending) {
+        Batch flushed;
+        flushed.deviceId = std::move(batch.deviceId);
+        flushed.deviceClass = batch.deviceClass;
+        flushed.frameCount = batch.frameCount;
+        flushed.originalSize = batch.buffer.size();
+        flushed.result = compressor(batch.deviceClass, batch.buffer);
+        onFlush(flushed);
+    }
+}
+
+std::vector<std::string> BatchScheduler::splitFrames(const std::string& batch) {
+    std::vector<std::string> frames;
+    size_t pos = 0;
+
+    while (pos < batch.size()) {
+        size_t length = 0;
+        int shift = 0;
+        while (pos < batch.size()) {
+            unsigned char byte = static_cast<unsigned char>(batch[pos++]);
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+
+        if (pos + length > batch.size()) {
+            break;  // truncated batch
+        }
+        frames.push_back(batch.substr(pos, length));
+        pos += length;
+    }
+
+    return frames;
+}
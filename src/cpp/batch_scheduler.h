@@ -0,0 +1,114 @@
+#ifndef BATCH_SCHEDULER_H
+#define BATCH_SCHEDULER_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "dictionary.h"
+#include "timing_wheel.h"
+
+// Per-device micro-batching of incoming frames.
+//
+// Compressing 40-byte frames one at a time spends most of the CPU on
+// per-call overhead and gets almost no ratio. The scheduler instead appends
+// each device's frames to a buffer and compresses the buffer in one call once
+// it reaches the device class's size limit or its oldest frame reaches the
+// class's latency deadline. Deadlines are tracked in a hierarchical timing
+// wheel with one timer per device, so 100k devices cost O(1) per frame.
+//
+// Frames are stored with a varint length prefix so the receiver can split a
+// decompressed batch back into frames.
+//
+// submit() never compresses: a buffer that reaches its size limit is queued
+// and compressed by the next poll(), so callers on latency-sensitive threads
+// (network I/O) only pay for a copy. Run poll() from a dedicated thread.
+// When poll() falls behind and the queue holds maxQueuedBytes, submit()
+// refuses new frames until it drains.
+class BatchScheduler {
+public:
+    struct Policy {
+        size_t maxBytes;       // flush once the buffer reaches this size
+        uint32_t maxDelayMs;   // flush once the oldest frame is this old
+    };
+
+    struct Batch {
+        std::string deviceId;
+        Dictionary::DeviceClass deviceClass;
+        size_t frameCount;
+        size_t originalSize;
+        std::pair<std::string, double> result;
+    };
+
+    typedef std::function<std::pair<std::string, double>(Dictionary::DeviceClass, const std::string&)> Compressor;
+    typedef std::function<void(const Batch&)> FlushHandler;
+
+    BatchScheduler(Compressor compressor, FlushHandler onFlush, uint64_t nowMs = currentTimeMs());
+
+    void setPolicy(Dictionary::DeviceClass deviceClass, const Policy& policy);
+    Policy policy(Dictionary::DeviceClass deviceClass) const;
+
+    // Queued bytes awaiting compression before submit() refuses frames
+    static constexpr size_t DEFAULT_MAX_QUEUED_BYTES = 16 * 1024 * 1024;
+
+    void setMaxQueuedBytes(size_t maxQueuedBytes);
+
+    // Queue a frame. A buffer it fills is handed to the next poll(). Returns
+    // false, dropping the frame, while the queue is full.
+    bool submit(const std::string& deviceId, Dictionary::DeviceClass deviceClass,
+                const std::string& frame, uint64_t nowMs = currentTimeMs());
+
+    // Flush every full buffer and every device whose deadline has passed
+    void poll(uint64_t nowMs = currentTimeMs());
+
+    // Flush every non-empty buffer regardless of deadlines
+    void flushAll();
+
+    size_t deviceCount() const;
+    size_t queuedBytes() const;
+
+    static uint64_t currentTimeMs();
+
+    // Split a decompressed batch back into its frames
+    static std::vector<std::string> splitFrames(const std::string& batch);
+
+private:
+    struct Device {
+        std::string id;
+        Dictionary::DeviceClass deviceClass;
+        std::string buffer;
+        size_t frameCount = 0;
+    };
+
+    struct Pending {
+        std::string deviceId;
+        Dictionary::DeviceClass deviceClass;
+        std::string buffer;
+        size_t frameCount;
+    };
+
+    // Detach a device's buffer for compression outside the lock
+    Pending take(uint32_t slot);
+
+    // Detach a device's buffer onto the ready queue for the next poll()
+    void enqueue(uint32_t slot);
+    void compressAndFlush(std::vector<Pending>& pending);
+
+    Compressor compressor;
+    FlushHandler onFlush;
+
+    mutable std::mutex mutex;
+    std::array<Policy, Dictionary::DEVICE_CLASS_COUNT> policies;
+    std::unordered_map<std::string, uint32_t> slots;
+    std::vector<Device> devices;
+    TimingWheel wheel;
+    std::vector<Pending> ready;  // full buffers waiting for poll()
+    size_t readyBytes = 0;
+    size_t maxQueuedBytes = DEFAULT_MAX_QUEUED_BYTES;
+};
+
+#endif // BATCH_SCHEDULER_H
@@ -0,0 +1,451 @@
+#include "columnar.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace Columnar {
+    // Records transposed per block; a block of a typical 17-byte record and
+    // its columns stay well inside L1
+    const size_t BLOCK_RECORDS = 256;
+
+    // Xor header for a repeated value; real headers never exceed 0x77
+    const unsigned char XOR_UNCHANGED = 0xFF;
+
+    size_t recordSize(const Schema& schema) {
+        size_t size = 0;
+        for (const Field& field : schema) {
+            size += field.size;
+        }
+        return size;
+    }
+
+    Schema sensorRecordSchema() {
+        return {
+            {"timestamp", 8, Codec::DeltaOfDelta},
+            {"temperature", 4, Codec::Xor},
+            {"humidity", 4, Codec::Xor},
+            {"status", 1, Codec::RLE}
+        };
+    }
+
+    // Copy one field of every record in [first, last) into its column. The
+    // fixed-width cases turn each copy into a single load and store; the
+    // loops stay scalar because the source is strided by the record size.
+    template<size_t WIDTH>
+    void gatherField(const char* records, size_t stride, size_t offset, size_t first, size_t last, char* column) {
+        for (size_t r = first; r < last; r++) {
+            std::memcpy(column + r * WIDTH, records + r * stride + offset, WIDTH);
+        }
+    }
+
+    template<size_t WIDTH>
+    void scatterField(const char* column, size_t stride, size_t offset, size_t first, size_t last, char* records) {
+        for (size_t r = first; r < last; r++) {
+            std::memcpy(records + r * stride + offset, column + r * WIDTH, WIDTH);
+        }
+    }
+
+#if defined(__SSE2__) || defined(_M_X64)
+    // SSE2 (baseline on x86-64) for the common 4- and 8-byte fields: strided
+    // loads from 16 / 8 bytes' worth of records are packed in registers and
+    // written to the column with one 16-byte store, and the reverse for
+    // scatter. The remaining records use the scalar loop.
+    template<>
+    void gatherField<4>(const char* records, size_t stride, size_t offset, size_t first, size_t last, char* column) {
+        const char* src = records + offset;
+        size_t r = first;
+        for (; r + 4 <= last; r += 4) {
+            int32_t v0, v1, v2, v3;
+            std::memcpy(&v0, src + r * stride, 4);
+            std::memcpy(&v1, src + (r + 1) * stride, 4);
+            std::memcpy(&v2, src + (r + 2) * stride, 4);
+            std::memcpy(&v3, src + (r + 3) * stride, 4);
+            __m128i low = _mm_unpacklo_epi32(_mm_cvtsi32_si128(v0), _mm_cvtsi32_si128(v1));
+            __m128i high = _mm_unpacklo_epi32(_mm_cvtsi32_si128(v2), _mm_cvtsi32_si128(v3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(column + r * 4), _mm_unpacklo_epi64(low, high));
+        }
+        for (; r < last; r++) {
+            std::memcpy(column + r * 4, src + r * stride, 4);
+        }
+    }
+
+    template<>
+    void gatherField<8>(const char* records, size_t stride, size_t offset, size_t first, size_t last, char* column) {
+        const char* src = records + offset;
+        size_t r = first;
+        for (; r + 2 <= last; r += 2) {
+            __m128i v0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + r * stride));
+            __m128i v1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + (r + 1) * stride));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(column + r * 8), _mm_unpacklo_epi64(v0, v1));
+        }
+        for (; r < last; r++) {
+            std::memcpy(column + r * 8, src + r * stride, 8);
+        }
+    }
+
+    template<>
+    void scatterField<4>(const char* column, size_t stride, size_t offset, size_t first, size_t last, char* records) {
+        char* dst = records + offset;
+        size_t r = first;
+        for (; r + 4 <= last; r += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + r * 4));
+            int32_t v0 = _mm_cvtsi128_si32(v);
+            int32_t v1 = _mm_cvtsi128_si32(_mm_srli_si128(v, 4));
+            int32_t v2 = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+            int32_t v3 = _mm_cvtsi128_si32(_mm_srli_si128(v, 12));
+            std::memcpy(dst + r * stride, &v0, 4);
+            std::memcpy(dst + (r + 1) * stride, &v1, 4);
+            std::memcpy(dst + (r + 2) * stride, &v2, 4);
+            std::memcpy(dst + (r + 3) * stride, &v3, 4);
+        }
+        for (; r < last; r++) {
+            std::memcpy(dst + r * stride, column + r * 4, 4);
+        }
+    }
+
+    template<>
+    void scatterField<8>(const char* column, size_t stride, size_t offset, size_t first, size_t last, char* records) {
+        char* dst = records + offset;
+        size_t r = first;
+        for (; r + 2 <= last; r += 2) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + r * 8));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + r * stride), v);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + (r + 1) * stride), _mm_unpackhi_epi64(v, v));
+        }
+        for (; r < last; r++) {
+            std::memcpy(dst + r * stride, column + r * 8, 8);
+        }
+    }
+#endif
+
+    std::vector<std::string> transpose(const std::string& records, const Schema& schema) {
+        size_t stride = recordSize(schema);
+        size_t count = stride ? records.size() / stride : 0;
+
+        std::vector<std::string> columns(schema.size());
+        for (size_t f = 0; f < schema.size(); f++) {
+            columns[f].resize(count * schema[f].size);
+        }
+
+        const char* input = records.data();
+        for (size_t first = 0; first < count; first += BLOCK_RECORDS) {
+            size_t last = std::min(count, first + BLOCK_RECORDS);
+            size_t offset = 0;
+
+            for (size_t f = 0; f < schema.size(); f++) {
+                size_t width = schema[f].size;
+                char* column = &columns[f][0];
+
+                switch (width) {
+                    case 1: gatherField<1>(input, stride, offset, first, last, column); break;
+                    case 2: gatherField<2>(input, stride, offset, first, last, column); break;
+                    case 4: gatherField<4>(input, stride, offset, first, last, column); break;
+                    case 8: gatherField<8>(input, stride, offset, first, last, column); break;
+                    default:
+                        for (size_t r = first; r < last; r++) {
+                            std::memcpy(column + r * width, input + r * stride + offset, width);
+                        }
+                }
+                offset += width;
+            }
+        }
+
+        return columns;
+    }
+
+    std::string untranspose(const std::vector<std::string>& columns, const Schema& schema) {
+        size_t stride = recordSize(schema);
+        if (columns.size() != schema.size() || schema.empty() || schema[0].size == 0) {
+            return "";
+        }
+
+        size_t count = columns[0].size() / schema[0].size;
+        std::string records(count * stride, '\0');
+        char* output = &records[0];
+
+        for (size_t first = 0; first < count; first += BLOCK_RECORDS) {
+            size_t last = std::min(count, first + BLOCK_RECORDS);
+            size_t offset = 0;
+
+            for (size_t f = 0; f < schema.size(); f++) {
+                size_t width = schema[f].size;
+                const char* column = columns[f].data();
+
+                switch (width) {
+                    case 1: scatterField<1>(column, stride, offset, first, last, output); break;
+                    case 2: scatterField<2>(column, stride, offset, first, last, output); break;
+                    case 4: scatterField<4>(column, stride, offset, first, last, output); break;
+                    case 8: scatterField<8>(column, stride, offset, first, last, output); break;
+                    default:
+                        for (size_t r = first; r < last; r++) {
+                            std::memcpy(output + r * stride + offset, column + r * width, width);
+                        }
+                }
+                offset += width;
+            }
+        }
+
+        return records;
+    }
+
+    void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    bool getVarint(const std::string& in, size_t& pos, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            unsigned char byte = static_cast<unsigned char>(in[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t zigzag(uint64_t value) {
+        return (value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+    }
+
+    uint64_t unzigzag(uint64_t value) {
+        return (value >> 1) ^ (~(value & 1) + 1);
+    }
+
+    uint64_t widthMask(size_t width) {
+        return width >= 8 ? ~uint64_t(0) : (uint64_t(1) << (8 * width)) - 1;
+    }
+
+    // Sign-extend a width-byte difference so small negative steps stay small
+    uint64_t signExtend(uint64_t value, size_t width) {
+        if (width >= 8) {
+            return value;
+        }
+        uint64_t signBit = uint64_t(1) << (8 * width - 1);
+        return (value ^ signBit) - signBit;
+    }
+
+    uint64_t loadValue(const char* p, size_t width) {
+        uint64_t value = 0;
+        std::memcpy(&value, p, width);
+        return value;
+    }
+
+    void storeValue(std::string& out, uint64_t value, size_t width) {
+        char bytes[8];
+        std::memcpy(bytes, &value, sizeof(bytes));
+        out.append(bytes, width);
+    }
+
+    // Column codecs. All arithmetic wraps in uint64 and is masked to the
+    // field width, so decoding reproduces the exact bit pattern.
+
+    std::string encodeColumn(const std::string& column, size_t width, Codec codec) {
+        if (codec == Codec::Raw || width > 8) {
+            return column;
+        }
+
+        std::string out;
+        size_t count = column.size() / width;
+        uint64_t mask = widthMask(width);
+        uint64_t previous = 0;
+        uint64_t previousDelta = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            uint64_t value = loadValue(column.data() + i * width, width);
+
+            switch (codec) {
+                case Codec::Delta:
+                    putVarint(out, zigzag(signExtend((value - previous) & mask, width)));
+                    break;
+
+                case Codec::DeltaOfDelta: {
+                    uint64_t delta = signExtend((value - previous) & mask, width);
+                    putVarint(out, zigzag(delta - previousDelta));
+                    previousDelta = delta;
+                    break;
+                }
+
+                case Codec::Xor: {
+                    // Header byte: leading zero bytes << 4 | trailing zero
+                    // bytes, then only the bytes in between. An unchanged
+                    // value is the single byte XOR_UNCHANGED.
+                    uint64_t x = value ^ previous;
+                    if (x == 0) {
+                        out.push_back(static_cast<char>(XOR_UNCHANGED));
+                        break;
+                    }
+                    size_t leading = 0;
+                    while (leading < width && !((x >> (8 * (width - 1 - leading))) & 0xFF)) {
+                        leading++;
+                    }
+                    size_t trailing = 0;
+                    while (!((x >> (8 * trailing)) & 0xFF)) {
+                        trailing++;
+                    }
+                    out.push_back(static_cast<char>((leading << 4) | trailing));
+                    storeValue(out, x >> (8 * trailing), width - leading - trailing);
+                    break;
+                }
+
+                case Codec::RLE: {
+                    size_t run = 1;
+                    while (i + run < count && loadValue(column.data() + (i + run) * width, width) == value) {
+                        run++;
+                    }
+                    putVarint(out, run);
+                    storeValue(out, value, width);
+                    i += run - 1;
+                    break;
+                }
+
+                case Codec::Raw:
+                    break;
+            }
+
+            previous = value;
+        }
+
+        return out;
+    }
+
+    bool decodeColumn(const std::string& in, size_t count, size_t width, Codec codec, std::string& column) {
+        if (codec == Codec::Raw || width > 8) {
+            column = in;
+            return in.size() == count * width;
+        }
+
+        column.clear();
+        uint64_t mask = widthMask(width);
+        uint64_t previous = 0;
+        uint64_t previousDelta = 0;
+        size_t pos = 0;
+
+        while (column.size() < count * width) {
+            uint64_t value = 0;
+            uint64_t encoded = 0;
+
+            switch (codec) {
+                case Codec::Delta:
+                    if (!getVarint(in, pos, encoded)) return false;
+                    value = (previous + unzigzag(encoded)) & mask;
+                    break;
+
+                case Codec::DeltaOfDelta:
+                    if (!getVarint(in, pos, encoded)) return false;
+                    previousDelta += unzigzag(encoded);
+                    value = (previous + previousDelta) & mask;
+                    break;
+
+                case Codec::Xor: {
+                    if (pos >= in.size()) return false;
+                    unsigned char header = static_cast<unsigned char>(in[pos++]);
+                    uint64_t x = 0;
+                    if (header != XOR_UNCHANGED) {
+                        size_t leading = header >> 4;
+                        size_t trailing = header & 0x0F;
+                        if (leading + trailing >= width) {
+                            return false;
+                        }
+                        size_t bytes = width - leading - trailing;
+                        if (pos + bytes > in.size()) return false;
+                        x = loadValue(in.data() + pos, bytes) << (8 * trailing);
+                        pos += bytes;
+                    }
+                    value = previous ^ x;
+                    break;
+                }
+
+                case Codec::RLE: {
+                    uint64_t run = 0;
+                    if (!getVarint(in, pos, run) || run == 0 || pos + width > in.size()) return false;
+                    if (run > count - column.size() / width) return false;
+                    value = loadValue(in.data() + pos, width);
+                    pos += width;
+                    for (uint64_t r = 1; r < run; r++) {
+                        storeValue(column, value, width);
+                    }
+                    break;
+                }
+
+                case Codec::Raw:
+                    break;
+            }
+
+            storeValue(column, value, width);
+            previous = value;
+        }
+
+        return pos == in.size();
+    }
+
+    // Layout: varint record count, then per field a varint length and the
+    // coded column, then a varint length and any trailing partial record
+    std::pair<std::string, double> compress(const std::string& data, const Schema& schema) {
+        if (data.empty()) {
+            return {"", 0.0};
+        }
+
+        size_t stride = recordSize(schema);
+        size_t count = stride ? data.size() / stride : 0;
+        std::vector<std::string> columns = transpose(data, schema);
+
+        std::string encodedData;
+        putVarint(encodedData, count);
+        for (size_t f = 0; f < schema.size(); f++) {
+            std::string encodedColumn = encodeColumn(columns[f], schema[f].size, schema[f].codec);
+            putVarint(encodedData, encodedColumn.size());
+            encodedData += encodedColumn;
+        }
+
+        size_t tail = data.size() - count * stride;
+        putVarint(encodedData, tail);
+        encodedData.append(data, count * stride, tail);
+
+        // Calculate compression ratio
+        double originalSize = data.size() * 8; // in bits
+        double compressedSize = encodedData.size() * 8; // in bits
+        double compressionRatio = 1.0 - (compressedSize / originalSize);
+
+        return {encodedData, compressionRatio};
+    }
+
+    std::string decompress(const std::string& encoded, const Schema& schema) {
+        if (encoded.empty() || schema.empty()) {
+            return "";
+        }
+
+        size_t pos = 0;
+        uint64_t count = 0;
+        if (!getVarint(encoded, pos, count)) {
+            return "";
+        }
+
+        std::vector<std::string> columns(schema.size());
+        for (size_t f = 0; f < schema.size(); f++) {
+            uint64_t length = 0;
+            if (!getVarint(encoded, pos, length) || length > encoded.size() - pos) {
+                return "";
+            }
+            if (!decodeColumn(encoded.substr(pos, length), count, schema[f].size, schema[f].codec, columns[f])) {
+                return "";
+            }
+            pos += length;
+        }
+
+        uint64_t tail = 0;
+        if (!getVarint(encoded, pos, tail) || tail != encoded.size() - pos) {
+            return "";
+        }
+
+        return untranspose(columns, schema) + encoded.substr(pos);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Schema-driven columnar coding of packed binary records.
+//
+// Delta::compress differences consecutive bytes, which on array-of-structs
+// input mixes unrelated fields. Here a fixed record layout is described up
+// front; records are transposed into one column per field and each column
+// is coded on its own with a codec suited to the field (delta-of-delta for
+// timestamps, XOR for floats, run-length for status codes). Decoding
+// reverses the codecs and transposes back.
+//
+// Fields are little-endian and 1, 2, 4 or 8 bytes wide.
+namespace Columnar {
+    enum class Codec {
+        Raw,           // stored as is
+        Delta,         // difference from the previous value
+        DeltaOfDelta,  // difference of differences; near zero for regular clocks
+        Xor,           // XOR with the previous value; for float bit patterns
+        RLE            // (run length, value) pairs
+    };
+
+    struct Field {
+        std::string name;
+        size_t size;
+        Codec codec;
+    };
+
+    typedef std::vector<Field> Schema;
+
+    size_t recordSize(const Schema& schema);
+
+    // {timestamp: u64, temperature: f32, humidity: f32, status: u8}
+    Schema sensorRecordSchema();
+
+    // Array-of-structs <-> struct-of-arrays, in cache-sized blocks of records.
+    // Trailing bytes that do not form a whole record are not included.
+    std::vector<std::string> transpose(const std::string& records, const Schema& schema);
+    std::string untranspose(const std::vector<std::string>& columns, const Schema& schema);
+
+    // LEB128 varints and zigzag mapping used by the column codecs
+    void putVarint(std::string& out, uint64_t value);
+    bool getVarint(const std::string& in, size_t& pos, uint64_t& value);
+    uint64_t zigzag(uint64_t value);
+    uint64_t unzigzag(uint64_t value);
+
+    std::pair<std::string, double> compress(const std::string& data, const Schema& schema);
+
+    // Returns an empty string if the encoded data is malformed
+    std::string decompress(const std::string& encoded, const Schema& schema);
+}
+
+#endif // COLUMNAR_H
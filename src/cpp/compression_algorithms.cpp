@@ -6,6 +6,11 @@
 #include <fstream>
 #include <algorithm>
 #include <chrono>
+#include <cstring>
+#include "aggregation.h"
+#include "batch_scheduler.h"
+#include "columnar.h"
+#include "compression_algorithms.h"
 
 // Huffman Coding implementation
 namespace Huffman {
@@ -127,6 +132,272 @@ namespace Huffman {
         
         return {encodedData, compressionRatio};
     }
+    
+    // Build a code table covering every byte value
+    std::array<std::string, 256> buildCodeTable(const std::array<uint32_t, 256>& frequencies) {
+        std::unordered_map<char, int> frequencyMap;
+        for (size_t i = 0; i < frequencies.size(); i++) {
+            frequencyMap[static_cast<char>(i)] = static_cast<int>(frequencies[i]);
+        }
+        
+        Node* root = buildHuffmanTree(frequencyMap);
+        
+        std::unordered_map<char, std::string> codes;
+        generateCodes(root, "", codes);
+        delete root;
+        
+        std::array<std::string, 256> table;
+        for (const auto& pair : codes) {
+            table[static_cast<unsigned char>(pair.first)] = pair.second;
+        }
+        return table;
+    }
+    
+    // Compress data using the dictionary's prebuilt codes
+    std::pair<std::string, double> compress(const std::string& data, const Dictionary::Trained& dictionary) {
+        if (data.empty()) {
+            return {"", 0.0};
+        }
+        
+        std::string encodedData;
+        for (char c : data) {
+            encodedData += dictionary.huffmanCodes[static_cast<unsigned char>(c)];
+        }
+        
+        // Calculate compression ratio
+        double originalSize = data.size() * 8; // in bits
+        double compressedSize = encodedData.size(); // in bits
+        double compressionRatio = 1.0 - (compressedSize / originalSize);
+        
+        return {encodedData, compressionRatio};
+    }
+}
+
+// Run-Length Encoding implementation
+//
+// (count, byte) pairs with counts of 1 to 255
+namespace RLE {
+    std::pair<std::string, double> compress(const std::string& data) {
+        if (data.empty()) {
+            return {"", 0.0};
+        }
+        
+        std::string encodedData;
+        size_t i = 0;
+        while (i < data.size()) {
+            size_t run = 1;
+            while (i + run < data.size() && run < 255 && data[i + run] == data[i]) {
+                run++;
+            }
+            encodedData.push_back(static_cast<char>(run));
+            encodedData.push_back(data[i]);
+            i += run;
+        }
+        
+        // Calculate compression ratio
+        double originalSize = data.size() * 8; // in bits
+        double compressedSize = encodedData.size() * 8; // in bits
+        double compressionRatio = 1.0 - (compressedSize / originalSize);
+        
+        return {encodedData, compressionRatio};
+    }
+    
+    std::string decompress(const std::string& encoded) {
+        if (encoded.size() % 2 != 0) {
+            return "";
+        }
+        
+        std::string data;
+        for (size_t i = 0; i < encoded.size(); i += 2) {
+            unsigned char run = static_cast<unsigned char>(encoded[i]);
+            if (run == 0) {
+                return "";
+            }
+            data.append(run, encoded[i + 1]);
+        }
+        return data;
+    }
+}
+
+// LZ77 implementation
+//
+// Byte-oriented token stream:
+//   0lllllll             literal run of l + 1 bytes, followed by the bytes
+//   1lllllll oooo oooo   match of l + MIN_MATCH bytes at 16-bit offset o
+//
+// Offsets count back from the current position. With a dictionary, the
+// dictionary content is treated as if it preceded the data, so a match can
+// start inside it.
+namespace LZ77 {
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_MATCH = MIN_MATCH + 127;
+    const size_t MAX_LITERALS = 128;
+    const size_t MAX_OFFSET = 65535;
+    
+    void flushLiterals(std::string& encodedData, const std::string& data, size_t start, size_t end) {
+        while (start < end) {
+            size_t count = std::min(MAX_LITERALS, end - start);
+            encodedData.push_back(static_cast<char>(count - 1));
+            encodedData.append(data, start, count);
+            start += count;
+        }
+    }
+    
+    std::pair<std::string, double> compress(const std::string& data, const Dictionary::Trained* dictionary) {
+        if (data.empty()) {
+            return {"", 0.0};
+        }
+        
+        const unsigned char* input = reinterpret_cast<const unsigned char*>(data.data());
+        const unsigned char* dict = nullptr;
+        size_t dictSize = 0;
+        if (dictionary) {
+            dict = reinterpret_cast<const unsigned char*>(dictionary->content.data());
+            dictSize = dictionary->content.size();
+        }
+        
+        // Length of the match between data[pos..] and the virtual window
+        // (dictionary followed by data) at windowPos
+        auto matchLength = [&](size_t windowPos, size_t pos) {
+            size_t limit = std::min(MAX_MATCH, data.size() - pos);
+            size_t length = 0;
+            while (windowPos < dictSize && length < limit && dict[windowPos] == input[pos + length]) {
+                windowPos++;
+                length++;
+            }
+            if (windowPos >= dictSize) {
+                const unsigned char* candidate = input + (windowPos - dictSize);
+                size_t start = length;
+                while (length < limit && candidate[length - start] == input[pos + length]) {
+                    length++;
+                }
+            }
+            return length;
+        };
+        
+        // Hash table over the data only, sized to the input so that small
+        // frames do not pay for clearing a large table
+        size_t tableSize = 1;
+        while (tableSize < data.size() && tableSize < Dictionary::HASH_SIZE) {
+            tableSize <<= 1;
+        }
+        std::vector<int32_t> table(tableSize, -1);
+        
+        std::string encodedData;
+        size_t literalStart = 0;
+        size_t pos = 0;
+        
+        while (pos + MIN_MATCH <= data.size()) {
+            uint32_t hash = Dictionary::hash4(input + pos);
+            size_t windowPos = dictSize + pos;
+            size_t bestLength = 0;
+            size_t bestOffset = 0;
+            
+            int32_t candidate = table[hash & (tableSize - 1)];
+            if (candidate >= 0) {
+                size_t length = matchLength(dictSize + candidate, pos);
+                if (length >= MIN_MATCH && pos - candidate <= MAX_OFFSET) {
+                    bestLength = length;
+                    bestOffset = pos - candidate;
+                }
+            }
+            
+            if (dictionary && bestLength < MAX_MATCH) {
+                int32_t dictCandidate = dictionary->hashIndex[hash];
+                if (dictCandidate >= 0 && windowPos - dictCandidate <= MAX_OFFSET) {
+                    size_t length = matchLength(dictCandidate, pos);
+                    if (length >= MIN_MATCH && length > bestLength) {
+                        bestLength = length;
+                        bestOffset = windowPos - dictCandidate;
+                    }
+                }
+            }
+            
+            table[hash & (tableSize - 1)] = static_cast<int32_t>(pos);
+            
+            if (bestLength == 0) {
+                pos++;
+                continue;
+            }
+            
+            flushLiterals(encodedData, data, literalStart, pos);
+            encodedData.push_back(static_cast<char>(0x80 | (bestLength - MIN_MATCH)));
+            encodedData.push_back(static_cast<char>(bestOffset & 0xFF));
+            encodedData.push_back(static_cast<char>(bestOffset >> 8));
+            
+            // Index the positions covered by the match
+            for (size_t i = pos + 1; i < pos + bestLength && i + MIN_MATCH <= data.size(); i++) {
+                table[Dictionary::hash4(input + i) & (tableSize - 1)] = static_cast<int32_t>(i);
+            }
+            
+            pos += bestLength;
+            literalStart = pos;
+        }
+        
+        flushLiterals(encodedData, data, literalStart, data.size());
+        
+        // Calculate compression ratio
+        double originalSize = data.size() * 8; // in bits
+        double compressedSize = encodedData.size() * 8; // in bits
+        double compressionRatio = 1.0 - (compressedSize / originalSize);
+        
+        return {encodedData, compressionRatio};
+    }
+    
+    std::pair<std::string, double> compress(const std::string& data) {
+        return compress(data, nullptr);
+    }
+    
+    std::pair<std::string, double> compress(const std::string& data, const Dictionary::Trained& dictionary) {
+        return compress(data, &dictionary);
+    }
+    
+    std::string decompress(const std::string& encoded, const std::string& prefix) {
+        std::string window = prefix;
+        size_t pos = 0;
+        
+        while (pos < encoded.size()) {
+            unsigned char token = static_cast<unsigned char>(encoded[pos++]);
+            
+            if (!(token & 0x80)) {
+                size_t count = token + 1;
+                if (pos + count > encoded.size()) {
+                    return "";
+                }
+                window.append(encoded, pos, count);
+                pos += count;
+                continue;
+            }
+            
+            if (pos + 2 > encoded.size()) {
+                return "";
+            }
+            size_t length = (token & 0x7F) + MIN_MATCH;
+            size_t offset = static_cast<unsigned char>(encoded[pos]) |
+                            (static_cast<size_t>(static_cast<unsigned char>(encoded[pos + 1])) << 8);
+            pos += 2;
+            
+            if (offset == 0 || offset > window.size()) {
+                return "";
+            }
+            
+            // Byte by byte, since a match may overlap its own output
+            size_t source = window.size() - offset;
+            for (size_t i = 0; i < length; i++) {
+                window.push_back(window[source + i]);
+            }
+        }
+        
+        return window.substr(prefix.size());
+    }
+    
+    std::string decompress(const std::string& encoded) {
+        return decompress(encoded, std::string());
+    }
+    
+    std::string decompress(const std::string& encoded, const Dictionary::Trained& dictionary) {
+        return decompress(encoded, dictionary.content);
+    }
 }
 
 // Delta Encoding implementation
@@ -175,12 +446,181 @@ void runCompressionBenchmark(const std::string& inputData) {
     std::cout << "Delta compressed size: " << resultDelta.first.size() * 8 << " bits" << std::endl;
 }
 
-// Example usage
+// Example usage; servers that link this file define COMPRESSION_NO_MAIN
+#ifndef COMPRESSION_NO_MAIN
+// Report whether a codec decoded its own output back to the input
+bool checkRoundTrip(const std::string& name, const std::string& original, const std::string& decoded) {
+    if (decoded == original) {
+        return true;
+    }
+    std::cerr << name << ": round trip mismatch (" << original.size() << " bytes in, "
+              << decoded.size() << " bytes out)" << std::endl;
+    return false;
+}
+
 int main() {
+    int failures = 0;
     std::string testData = "This is a test string for compression algorithms. "
                           "It contains some repeated patterns to demonstrate compression.";
     
     runCompressionBenchmark(testData);
     
-    return 0;
+    // Small sensor frames compress poorly on their own; prime them with a
+    // dictionary trained on earlier frames from the same device class
+    std::vector<std::string> samples;
+    for (int i = 0; i < 500; i++) {
+        samples.push_back("{\"deviceId\":\"device-" + std::to_string(i % 8 + 1) +
+                          "\",\"type\":\"Sensor\",\"temperature\":" + std::to_string(20 + i % 7) +
+                          ".5,\"humidity\":" + std::to_string(40 + i % 13) + ",\"status\":\"active\"}");
+    }
+    Dictionary::Trained dictionary = Dictionary::train(samples);
+    
+    std::string frame = "{\"deviceId\":\"device-3\",\"type\":\"Sensor\",\"temperature\":22.5,"
+                        "\"humidity\":47,\"status\":\"active\"}";
+    auto resultLZ77 = LZ77::compress(frame);
+    auto resultPrimed = LZ77::compress(frame, dictionary);
+    auto resultHuffmanPrimed = Huffman::compress(frame, dictionary);
+    
+    std::cout << "Frame size: " << frame.size() << " bytes, dictionary: "
+              << dictionary.content.size() << " bytes" << std::endl;
+    std::cout << "LZ77: " << (resultLZ77.second * 100) << "% reduction" << std::endl;
+    std::cout << "LZ77 + dictionary: " << (resultPrimed.second * 100) << "% reduction" << std::endl;
+    std::cout << "Huffman + dictionary: " << (resultHuffmanPrimed.second * 100) << "% reduction" << std::endl;
+    
+    failures += !checkRoundTrip("LZ77", frame, LZ77::decompress(resultLZ77.first));
+    failures += !checkRoundTrip("LZ77 + dictionary", frame, LZ77::decompress(resultPrimed.first, dictionary));
+    failures += !checkRoundTrip("LZ77 test data", testData, LZ77::decompress(LZ77::compress(testData).first));
+    
+    // Batch frames per device the way /api/ingest does, then split a
+    // decoded batch back into the frames that went in
+    std::vector<std::string> sent;
+    std::vector<std::string> received;
+    BatchScheduler batchScheduler(
+        [&dictionary](Dictionary::DeviceClass, const std::string& batch) {
+            return LZ77::compress(batch, dictionary);
+        },
+        [&](const BatchScheduler::Batch& batch) {
+            std::vector<std::string> frames =
+                BatchScheduler::splitFrames(LZ77::decompress(batch.result.first, dictionary));
+            received.insert(received.end(), frames.begin(), frames.end());
+        },
+        0);
+    for (size_t i = 0; i < 200; i++) {
+        sent.push_back(samples[i]);
+        batchScheduler.submit("device-" + std::to_string(i % 4), Dictionary::DeviceClass::Sensor, samples[i], i);
+    }
+    batchScheduler.flushAll();
+    
+    // Batches arrive per device, so compare the frames irrespective of order
+    std::sort(sent.begin(), sent.end());
+    std::sort(received.begin(), received.end());
+    if (received != sent) {
+        std::cerr << "Batched frames: sent " << sent.size() << ", split back "
+                  << received.size() << std::endl;
+        failures++;
+    }
+    
+    // A 300-tick deadline crosses into the wheel's second level and must
+    // cascade back down to fire exactly on time
+    TimingWheel wheel(0);
+    uint64_t firedAt = 0;
+    wheel.schedule(0, 300);
+    for (uint64_t tick = 1; tick <= 400; tick++) {
+        wheel.advance(tick, [&firedAt, tick](uint32_t) { firedAt = tick; });
+    }
+    if (firedAt != 300) {
+        std::cerr << "Timing wheel: deadline 300 fired at " << firedAt << std::endl;
+        failures++;
+    }
+    
+    // Packed {timestamp, temperature, humidity, status} records: bytewise
+    // delta mixes the fields, the columnar transform codes each on its own
+    std::string records;
+    uint64_t timestamp = 1700000000000ULL;
+    float temperature = 21.5f;
+    float humidity = 40.0f;
+    for (int i = 0; i < 1000; i++) {
+        timestamp += 1000;
+        temperature += (i % 50 == 0) ? 0.5f : 0.0f;
+        humidity -= (i % 80 == 0) ? 1.0f : 0.0f;
+        unsigned char status = (i / 400) % 2;
+        
+        char record[17];
+        std::memcpy(record, &timestamp, 8);
+        std::memcpy(record + 8, &temperature, 4);
+        std::memcpy(record + 12, &humidity, 4);
+        record[16] = static_cast<char>(status);
+        records.append(record, sizeof(record));
+    }
+    
+    auto resultRecordsDelta = Delta::compress(records);
+    auto resultColumnar = Columnar::compress(records, Columnar::sensorRecordSchema());
+    
+    std::cout << "Sensor records: " << records.size() << " bytes" << std::endl;
+    std::cout << "Delta: " << (resultRecordsDelta.second * 100) << "% reduction" << std::endl;
+    std::cout << "Columnar: " << (resultColumnar.second * 100) << "% reduction" << std::endl;
+    
+    // Bytes past the last whole record travel as an uncoded tail
+    std::string partialRecords = records + std::string("\x01\x02\x03", 3);
+    auto resultPartial = Columnar::compress(partialRecords, Columnar::sensorRecordSchema());
+    failures += !checkRoundTrip("Columnar", records,
+                                Columnar::decompress(resultColumnar.first, Columnar::sensorRecordSchema()));
+    failures += !checkRoundTrip("Columnar + partial record", partialRecords,
+                                Columnar::decompress(resultPartial.first, Columnar::sensorRecordSchema()));
+    failures += !checkRoundTrip("RLE", records, RLE::decompress(RLE::compress(records).first));
+    
+    // A week of per-minute readings, aggregated over two days without
+    // decompressing the blocks in between
+    Aggregation::SeriesStore series;
+    std::vector<std::pair<uint64_t, int64_t>> rawSamples;
+    int64_t reading = 2150; // hundredths of a degree
+    for (uint64_t minute = 0; minute < 7 * 24 * 60; minute++) {
+        reading += (minute % 90 == 0) ? 5 : 0;
+        reading -= (minute % 600 == 300) ? 40 : 0;
+        series.append(minute * 60000, reading);
+        rawSamples.emplace_back(minute * 60000, reading);
+    }
+    
+    Aggregation::Result twoDays = series.query(2 * 24 * 3600000ULL, 4 * 24 * 3600000ULL);
+    std::cout << "Series: " << series.sampleCount() << " samples in " << series.compressedBytes()
+              << " bytes" << std::endl;
+    std::cout << "Two-day avg: " << twoDays.average() / 100 << ", min: " << twoDays.min / 100.0
+              << ", max: " << twoDays.max / 100.0 << " (" << twoDays.blocksFromSummary
+              << " blocks from summaries, " << twoDays.blocksDecoded << " decoded)" << std::endl;
+    
+    // Check query() against a straight pass over the raw samples. With
+    // 1024 samples per block, minutes [1024, 3072) are exactly blocks 1-2
+    // and the last 864 minutes are still in the unsealed pending block.
+    const uint64_t MINUTE = 60000;
+    const std::pair<uint64_t, uint64_t> ranges[] = {
+        {2 * 24 * 3600000ULL, 4 * 24 * 3600000ULL},  // the range printed above
+        {1024 * MINUTE, 3071 * MINUTE},              // whole blocks only
+        {1100 * MINUTE, 1500 * MINUTE},              // inside one block
+        {9000 * MINUTE, 9999 * MINUTE},              // ends in the pending block
+        {5 * MINUTE + 1, 6 * MINUTE - 1},            // between two samples: empty
+        {3000 * MINUTE, 2000 * MINUTE}               // from > to
+    };
+    for (const auto& range : ranges) {
+        Aggregation::Result expected;
+        for (const auto& sample : rawSamples) {
+            if (sample.first >= range.first && sample.first <= range.second) {
+                Aggregation::Result single;
+                single.count = 1;
+                single.min = single.max = single.sum = sample.second;
+                expected.merge(single);
+            }
+        }
+        
+        Aggregation::Result actual = series.query(range.first, range.second);
+        if (actual.count != expected.count || actual.min != expected.min ||
+            actual.max != expected.max || actual.sum != expected.sum) {
+            std::cerr << "Aggregation [" << range.first << ", " << range.second << "]: got count "
+                      << actual.count << " sum " << actual.sum << ", expected count "
+                      << expected.count << " sum " << expected.sum << std::endl;
+            failures++;
+        }
+    }
+    
+    return failures ? 1 : 0;
 }
+#endif // COMPRESSION_NO_MAIN
@@ -2,17 +2,45 @@
 #ifndef COMPRESSION_ALGORITHMS_H
 #define COMPRESSION_ALGORITHMS_H
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <utility>
+#include "dictionary.h"
 
 namespace Huffman {
     std::pair<std::string, double> compress(const std::string& data);
+
+    // Encode with the dictionary's prebuilt code table instead of building a
+    // tree from the (usually too small) input
+    std::pair<std::string, double> compress(const std::string& data, const Dictionary::Trained& dictionary);
+
+    // Code table for all 256 byte values; every frequency must be non-zero
+    std::array<std::string, 256> buildCodeTable(const std::array<uint32_t, 256>& frequencies);
 }
 
 namespace Delta {
     std::pair<std::string, double> compress(const std::string& data);
 }
 
+namespace RLE {
+    std::pair<std::string, double> compress(const std::string& data);
+
+    // Returns an empty string if the encoded data is malformed
+    std::string decompress(const std::string& encoded);
+}
+
+namespace LZ77 {
+    std::pair<std::string, double> compress(const std::string& data);
+
+    // Matches may reference the dictionary content as if it preceded the data
+    std::pair<std::string, double> compress(const std::string& data, const Dictionary::Trained& dictionary);
+
+    // Returns an empty string if the encoded data is malformed
+    std::string decompress(const std::string& encoded);
+    std::string decompress(const std::string& encoded, const Dictionary::Trained& dictionary);
+}
+
 void runCompressionBenchmark(const std::string& inputData);
 
 #endif // COMPRESSION_ALGORITHMS_H
@@ -0,0 +1,224 @@
+#include "dictionary.h"
+#include "compression_algorithms.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace Dictionary {
+    // Length of the substrings ("d-mers") whose frequency drives training
+    const size_t DMER_SIZE = 8;
+
+    // Size of the segments copied into the dictionary
+    const size_t SEGMENT_SIZE = 32;
+
+    const char FILE_MAGIC[4] = {'I', 'O', 'T', 'D'};
+
+    bool parseDeviceClass(const std::string& name, DeviceClass& deviceClass) {
+        std::string lower;
+        for (char c : name) {
+            lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+        }
+
+        if (lower == "sensor") deviceClass = DeviceClass::Sensor;
+        else if (lower == "controller") deviceClass = DeviceClass::Controller;
+        else if (lower == "gateway") deviceClass = DeviceClass::Gateway;
+        else if (lower == "camera") deviceClass = DeviceClass::Camera;
+        else return false;
+
+        return true;
+    }
+
+    std::string deviceClassName(DeviceClass deviceClass) {
+        switch (deviceClass) {
+            case DeviceClass::Sensor: return "sensor";
+            case DeviceClass::Controller: return "controller";
+            case DeviceClass::Gateway: return "gateway";
+            case DeviceClass::Camera: return "camera";
+        }
+        return "unknown";
+    }
+
+    // Pack a d-mer into an integer key
+    static uint64_t dmerKey(const unsigned char* data) {
+        uint64_t key = 0;
+        std::memcpy(&key, data, DMER_SIZE);
+        return key;
+    }
+
+    void finalize(Trained& dictionary) {
+        dictionary.huffmanCodes = Huffman::buildCodeTable(dictionary.frequencies);
+
+        dictionary.hashIndex.assign(HASH_SIZE, -1);
+        const unsigned char* content =
+            reinterpret_cast<const unsigned char*>(dictionary.content.data());
+        for (size_t i = 0; i + 4 <= dictionary.content.size(); i++) {
+            // Later positions overwrite earlier ones, favouring short offsets
+            dictionary.hashIndex[hash4(content + i)] = static_cast<int32_t>(i);
+        }
+    }
+
+    // Simplified COVER training: count in how many samples each d-mer
+    // occurs, split the samples into one epoch per dictionary segment and take
+    // the highest-scoring segment from each epoch. A d-mer only scores once,
+    // so the dictionary does not fill up with copies of the same text.
+    Trained train(const std::vector<std::string>& samples, size_t maxSize) {
+        maxSize = std::min(maxSize, MAX_DICTIONARY_SIZE);
+        Trained dictionary;
+        dictionary.frequencies.fill(1);
+
+        std::string corpus;
+        std::unordered_map<uint64_t, uint32_t> dmerFrequency;
+
+        for (const std::string& sample : samples) {
+            for (char c : sample) {
+                dictionary.frequencies[static_cast<unsigned char>(c)]++;
+            }
+
+            const unsigned char* data = reinterpret_cast<const unsigned char*>(sample.data());
+            std::unordered_map<uint64_t, bool> seen;
+            for (size_t i = 0; i + DMER_SIZE <= sample.size(); i++) {
+                uint64_t key = dmerKey(data + i);
+                if (!seen[key]) {
+                    seen[key] = true;
+                    dmerFrequency[key]++;
+                }
+            }
+
+            corpus += sample;
+        }
+
+        if (corpus.size() < SEGMENT_SIZE || maxSize < SEGMENT_SIZE) {
+            dictionary.content = corpus.substr(0, std::min(corpus.size(), maxSize));
+            finalize(dictionary);
+            return dictionary;
+        }
+
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(corpus.data());
+        size_t dmerCount = corpus.size() - DMER_SIZE + 1;
+        size_t epochs = std::max<size_t>(1, maxSize / SEGMENT_SIZE);
+        size_t epochSize = std::max(SEGMENT_SIZE, corpus.size() / epochs);
+        size_t window = SEGMENT_SIZE - DMER_SIZE + 1;
+
+        // (score, offset) of the segment chosen from each epoch
+        std::vector<std::pair<uint64_t, size_t>> segments;
+
+        for (size_t epochStart = 0; epochStart + SEGMENT_SIZE <= corpus.size(); epochStart += epochSize) {
+            size_t epochEnd = std::min(corpus.size() - SEGMENT_SIZE, epochStart + epochSize - 1);
+
+            // Slide a window over the epoch, summing the frequencies of the
+            // d-mers each candidate segment contains
+            uint64_t score = 0;
+            for (size_t i = epochStart; i < epochStart + window && i < dmerCount; i++) {
+                score += dmerFrequency[dmerKey(data + i)];
+            }
+
+            uint64_t bestScore = score;
+            size_t bestOffset = epochStart;
+            for (size_t offset = epochStart + 1; offset <= epochEnd; offset++) {
+                score -= dmerFrequency[dmerKey(data + offset - 1)];
+                if (offset + window - 1 < dmerCount) {
+                    score += dmerFrequency[dmerKey(data + offset + window - 1)];
+                }
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestOffset = offset;
+                }
+            }
+
+            // Nothing in this epoch recurs across samples
+            if (bestScore <= window) {
+                continue;
+            }
+
+            // Zero the chosen d-mers so later epochs pick different content
+            for (size_t i = bestOffset; i < bestOffset + window && i < dmerCount; i++) {
+                dmerFrequency[dmerKey(data + i)] = 0;
+            }
+            segments.push_back({bestScore, bestOffset});
+        }
+
+        // Best segments last, closest to the data being compressed
+        std::sort(segments.begin(), segments.end());
+        for (const auto& segment : segments) {
+            if (dictionary.content.size() + SEGMENT_SIZE > maxSize) {
+                break;
+            }
+            dictionary.content.append(corpus, segment.second, SEGMENT_SIZE);
+        }
+
+        finalize(dictionary);
+        return dictionary;
+    }
+
+    bool save(const Trained& dictionary, const std::string& path) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        uint32_t contentSize = static_cast<uint32_t>(dictionary.content.size());
+        file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        file.write(reinterpret_cast<const char*>(&contentSize), sizeof(contentSize));
+        file.write(dictionary.content.data(), contentSize);
+        file.write(reinterpret_cast<const char*>(dictionary.frequencies.data()),
+                   sizeof(uint32_t) * dictionary.frequencies.size());
+
+        return static_cast<bool>(file);
+    }
+
+    bool load(const std::string& path, Trained& dictionary) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        char magic[sizeof(FILE_MAGIC)];
+        uint32_t contentSize = 0;
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(&contentSize), sizeof(contentSize));
+        if (!file || std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+            contentSize > MAX_DICTIONARY_SIZE) {
+            return false;
+        }
+
+        dictionary.content.resize(contentSize);
+        file.read(&dictionary.content[0], contentSize);
+        file.read(reinterpret_cast<char*>(dictionary.frequencies.data()),
+                  sizeof(uint32_t) * dictionary.frequencies.size());
+        if (!file) {
+            return false;
+        }
+
+        for (uint32_t& frequency : dictionary.frequencies) {
+            frequency = std::max<uint32_t>(frequency, 1);
+        }
+
+        finalize(dictionary);
+        return true;
+    }
+
+    void Registry::install(DeviceClass deviceClass, Trained dictionary) {
+        dictionaries[static_cast<size_t>(deviceClass)] =
+            std::make_shared<const Trained>(std::move(dictionary));
+    }
+
+    size_t Registry::loadDirectory(const std::string& directory) {
+        size_t loaded = 0;
+        for (size_t i = 0; i < DEVICE_CLASS_COUNT; i++) {
+            DeviceClass deviceClass = static_cast<DeviceClass>(i);
+            Trained dictionary;
+            if (load(directory + "/" + deviceClassName(deviceClass) + ".dict", dictionary)) {
+                install(deviceClass, std::move(dictionary));
+                loaded++;
+            }
+        }
+        return loaded;
+    }
+
+    std::shared_ptr<const Trained> Registry::find(DeviceClass deviceClass) const {
+        return dictionaries[static_cast<size_t>(deviceClass)];
+    }
+}
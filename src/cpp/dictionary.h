@@ -0,0 +1,93 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Shared compression dictionaries trained per device class.
+//
+// A dictionary carries a block of representative content used to prime the
+// LZ77 window and a byte histogram used to prebuild Huffman codes, so a small
+// frame can reference context it never transmitted. Dictionaries are built
+// once at startup and are immutable afterwards, which lets every worker thread
+// share them without locking.
+namespace Dictionary {
+    // Mirrors the Device.type values modelled by the frontend
+    enum class DeviceClass {
+        Sensor,
+        Controller,
+        Gateway,
+        Camera
+    };
+
+    const size_t DEVICE_CLASS_COUNT = 4;
+
+    // Parse a frontend device type ("Sensor", "sensor", ...); false if unknown
+    bool parseDeviceClass(const std::string& name, DeviceClass& deviceClass);
+    std::string deviceClassName(DeviceClass deviceClass);
+
+    // Number of hash buckets used to index the dictionary content
+    const size_t HASH_BITS = 12;
+    const size_t HASH_SIZE = size_t(1) << HASH_BITS;
+
+    struct Trained {
+        // Priming content; the most valuable segments sit at the end so they
+        // get the shortest LZ77 offsets
+        std::string content;
+
+        // Byte histogram of the training samples (smoothed, never zero)
+        std::array<uint32_t, 256> frequencies;
+
+        // Huffman codes prebuilt from the histogram
+        std::array<std::string, 256> huffmanCodes;
+
+        // Latest content position for each 4-byte hash, -1 if none. Built
+        // once so compressing against the dictionary costs no setup.
+        std::vector<int32_t> hashIndex;
+    };
+
+    // Largest dictionary content; bounds what load() will allocate
+    const size_t MAX_DICTIONARY_SIZE = 16 * 1024;
+
+    // Train a dictionary of at most maxSize bytes (capped at
+    // MAX_DICTIONARY_SIZE) from sample frames
+    Trained train(const std::vector<std::string>& samples, size_t maxSize = MAX_DICTIONARY_SIZE);
+
+    // Rebuild the derived tables (Huffman codes, hash index) after the
+    // content or frequencies were set directly
+    void finalize(Trained& dictionary);
+
+    // Binary persistence so dictionaries can be trained offline (see
+    // train_dictionary.cpp). load() rejects files whose content exceeds
+    // MAX_DICTIONARY_SIZE.
+    bool save(const Trained& dictionary, const std::string& path);
+    bool load(const std::string& path, Trained& dictionary);
+
+    // Hash of the 4 bytes at data, shared by the trainer and LZ77
+    inline uint32_t hash4(const unsigned char* data) {
+        uint32_t value = uint32_t(data[0]) | (uint32_t(data[1]) << 8) |
+                         (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // One dictionary slot per device class. Populate it during startup, then
+    // hand it to worker threads by const reference; lookups never lock.
+    class Registry {
+    public:
+        void install(DeviceClass deviceClass, Trained dictionary);
+
+        // Loads "<dir>/<class>.dict" for every class present; returns the
+        // number of dictionaries loaded
+        size_t loadDirectory(const std::string& directory);
+
+        std::shared_ptr<const Trained> find(DeviceClass deviceClass) const;
+
+    private:
+        std::array<std::shared_ptr<const Trained>, DEVICE_CLASS_COUNT> dictionaries;
+    };
+}
+
+#endif // DICTIONARY_H
@@ -0,0 +1,558 @@
+// Load generator and latency profiler for the compression servers.
+//
+// Drives /api/compress and /api/compress/custom on one or more servers with
+// a fixed number of connections. Each connection either sends back to back
+// (closed loop) or follows an open-loop schedule at a share of the target
+// arrival rate. In open-loop mode latency is measured from when a request
+// was due rather than when it was actually sent, so a stalled server is
+// charged for the requests it held up (coordinated-omission correction).
+//
+// Example: compare both servers at three arrival rates
+//   ./load_generator --target raw=127.0.0.1:8081 --target crow=127.0.0.1:8082
+//       --concurrency 32 --duration 10 --rate 500,2000,8000 --mix 64:70,1024:25,65536:5
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <map>
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "Ws2_32.lib")
+    #define CLOSE_SOCKET closesocket
+    typedef SOCKET SocketType;
+#else
+    #include <unistd.h>
+    #include <netdb.h>
+    #include <arpa/inet.h>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #define CLOSE_SOCKET close
+    #define SOCKET_ERROR -1
+    #define INVALID_SOCKET -1
+    typedef int SocketType;
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+struct Target {
+    std::string name;
+    std::string host;
+    std::string port;
+};
+
+struct PayloadClass {
+    size_t size;
+    int weight;
+};
+
+struct Options {
+    std::vector<Target> targets;
+    std::vector<double> rates{0};  // requests per second overall; 0 = closed loop
+    std::vector<PayloadClass> mix{{256, 1}};
+    size_t concurrency = 8;
+    double duration = 10;
+    double customShare = 1.0;  // fraction of requests sent to /api/compress/custom
+    double repeatRatio = 0.0;  // fraction of custom requests that resend an earlier body
+    bool keepAlive = true;
+};
+
+// Per-run results merged from every connection
+struct RunResult {
+    std::vector<double> latenciesMs;
+    std::map<int, size_t> statusCounts;  // HTTP status, -1 for transport failures
+    size_t bytesSent = 0;
+    size_t connects = 0;
+    double elapsedSeconds = 0;
+};
+
+// Blocking HTTP/1.1 client connection that reconnects when the server
+// closes it
+class Connection {
+private:
+    const Target& target;
+    SocketType sock;
+    std::string buffer;
+
+    bool open() {
+        struct addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+
+        struct addrinfo* result = nullptr;
+        if (getaddrinfo(target.host.c_str(), target.port.c_str(), &hints, &result) != 0) {
+            return false;
+        }
+
+        sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (sock == INVALID_SOCKET) {
+            freeaddrinfo(result);
+            return false;
+        }
+
+        if (::connect(sock, result->ai_addr, static_cast<int>(result->ai_addrlen)) == SOCKET_ERROR) {
+            freeaddrinfo(result);
+            disconnect();
+            return false;
+        }
+        freeaddrinfo(result);
+
+        int noDelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+        // Do not hang forever on a wedged server
+#ifdef _WIN32
+        DWORD timeout = 10000;
+#else
+        struct timeval timeout;
+        timeout.tv_sec = 10;
+        timeout.tv_usec = 0;
+#endif
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+
+        buffer.clear();
+        connects++;
+        return true;
+    }
+
+    bool sendAll(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            int n = send(sock, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+            if (n <= 0) {
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+
+    // Append more bytes to the buffer; false on close or error
+    bool fill() {
+        char chunk[16384];
+        int n = recv(sock, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, n);
+        return true;
+    }
+
+    static std::string lower(std::string text) {
+        for (char& c : text) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return text;
+    }
+
+public:
+    size_t connects = 0;
+
+    Connection(const Target& target) : target(target), sock(INVALID_SOCKET) {}
+
+    ~Connection() {
+        disconnect();
+    }
+
+    void disconnect() {
+        if (sock != INVALID_SOCKET) {
+            CLOSE_SOCKET(sock);
+            sock = INVALID_SOCKET;
+        }
+    }
+
+    // Send a request and read the full response; returns the HTTP status or
+    // -1 if the exchange failed
+    int roundTrip(const std::string& request) {
+        if (sock == INVALID_SOCKET && !open()) {
+            return -1;
+        }
+
+        if (!sendAll(request)) {
+            // A kept-alive connection may have been closed by the server;
+            // retry once on a fresh one
+            disconnect();
+            if (!open() || !sendAll(request)) {
+                disconnect();
+                return -1;
+            }
+        }
+
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) {
+                disconnect();
+                return -1;
+            }
+        }
+
+        std::string headers = lower(buffer.substr(0, headerEnd));
+        int status = -1;
+        size_t space = headers.find(' ');
+        if (space != std::string::npos) {
+            status = std::atoi(headers.c_str() + space + 1);
+        }
+
+        bool serverCloses = headers.find("\r\nconnection: close") != std::string::npos;
+        size_t bodyStart = headerEnd + 4;
+        size_t lengthPos = headers.find("\r\ncontent-length:");
+
+        if (lengthPos != std::string::npos) {
+            size_t contentLength = std::strtoul(headers.c_str() + lengthPos + 17, nullptr, 10);
+            while (buffer.size() < bodyStart + contentLength) {
+                if (!fill()) {
+                    disconnect();
+                    return -1;
+                }
+            }
+            buffer.erase(0, bodyStart + contentLength);
+        } else {
+            // No length: the body runs until the server closes
+            while (fill()) {}
+            serverCloses = true;
+        }
+
+        if (serverCloses) {
+            disconnect();
+        }
+        return status;
+    }
+};
+
+std::string makePayload(size_t size, std::mt19937& gen) {
+    // Printable characters that need no JSON escaping
+    static const char alphabet[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ,.:;-_{}[]";
+    std::uniform_int_distribution<> dis(0, sizeof(alphabet) - 2);
+
+    std::string data;
+    data.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        data.push_back(alphabet[dis(gen)]);
+    }
+    return data;
+}
+
+// Counter spliced into custom payloads; shared by every connection, target
+// and rate so no two stamped bodies are ever identical
+std::atomic<uint64_t> nextPayloadId(0);
+
+// Overwrite the start of a custom request's payload with a request id, in
+// place, so the body is new to the server and its result cache misses
+void stampPayload(std::string& request, size_t payloadSize, uint64_t id) {
+    static const char digits[] = "0123456789abcdef";
+    size_t offset = request.size() - payloadSize - 2;  // the body ends with "}
+    size_t width = std::min<size_t>(payloadSize, 16);
+    for (size_t i = 0; i < width; ++i) {
+        request[offset + i] = digits[id & 0xF];
+        id >>= 4;
+    }
+}
+
+std::string makeRequest(const Target& target, bool custom, const std::string& data, bool keepAlive) {
+    std::string connection = keepAlive ? "keep-alive" : "close";
+    if (!custom) {
+        return "GET /api/compress HTTP/1.1\r\n"
+               "Host: " + target.host + "\r\n"
+               "Connection: " + connection + "\r\n\r\n";
+    }
+
+    std::string body = "{\"data\":\"" + data + "\"}";
+    return "POST /api/compress/custom HTTP/1.1\r\n"
+           "Host: " + target.host + "\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "Connection: " + connection + "\r\n\r\n" + body;
+}
+
+RunResult runLoad(const Target& target, const Options& options, double rate) {
+    RunResult merged;
+    std::mutex mergeMutex;
+
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.duration));
+
+    // Each connection carries an equal share of the arrival rate
+    double interval = rate > 0 ? options.concurrency / rate : 0;
+
+    int totalWeight = 0;
+    for (const PayloadClass& payload : options.mix) {
+        totalWeight += payload.weight;
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < options.concurrency; ++w) {
+        workers.emplace_back([&, w] {
+            std::mt19937 gen(static_cast<unsigned>(w * 7919 + 1));
+            std::uniform_int_distribution<> pickWeight(0, totalWeight - 1);
+            std::uniform_real_distribution<> pickEndpoint(0.0, 1.0);
+
+            // Build every request up front so the loop measures the server.
+            // Each send stamps a fresh id into customRequests; repeatRequests
+            // keep this connection's original bodies for --repeat-ratio.
+            std::vector<std::string> customRequests;
+            for (const PayloadClass& payload : options.mix) {
+                customRequests.push_back(makeRequest(target, true, makePayload(payload.size, gen), options.keepAlive));
+            }
+            const std::vector<std::string> repeatRequests = customRequests;
+            std::string generatedRequest = makeRequest(target, false, "", options.keepAlive);
+
+            Connection connection(target);
+            RunResult local;
+
+            // Stagger connections across one interval
+            double phase = interval * w / options.concurrency;
+
+            for (size_t k = 0; ; ++k) {
+                Clock::time_point intended = Clock::now();
+                if (interval > 0) {
+                    intended = start + std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>(phase + k * interval));
+                    if (intended >= end) {
+                        break;
+                    }
+                    std::this_thread::sleep_until(intended);
+                } else if (intended >= end) {
+                    break;
+                } else if (intended < start) {
+                    std::this_thread::sleep_until(start);
+                    intended = Clock::now();
+                }
+
+                const std::string* request = &generatedRequest;
+                if (pickEndpoint(gen) < options.customShare) {
+                    int pick = pickWeight(gen);
+                    size_t index = 0;
+                    while (pick >= options.mix[index].weight) {
+                        pick -= options.mix[index].weight;
+                        index++;
+                    }
+                    if (pickEndpoint(gen) < options.repeatRatio) {
+                        request = &repeatRequests[index];
+                    } else {
+                        stampPayload(customRequests[index], options.mix[index].size, nextPayloadId.fetch_add(1));
+                        request = &customRequests[index];
+                    }
+                }
+
+                int status = connection.roundTrip(*request);
+                Clock::time_point done = Clock::now();
+
+                local.latenciesMs.push_back(std::chrono::duration<double, std::milli>(done - intended).count());
+                local.statusCounts[status]++;
+                local.bytesSent += request->size();
+            }
+
+            local.connects = connection.connects;
+
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            merged.latenciesMs.insert(merged.latenciesMs.end(), local.latenciesMs.begin(), local.latenciesMs.end());
+            for (const auto& entry : local.statusCounts) {
+                merged.statusCounts[entry.first] += entry.second;
+            }
+            merged.bytesSent += local.bytesSent;
+            merged.connects += local.connects;
+        });
+    }
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    merged.elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return merged;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void printHeader() {
+    std::cout << std::left << std::setw(10) << "target"
+              << std::right << std::setw(10) << "rate"
+              << std::setw(10) << "req/s"
+              << std::setw(9) << "MB/s"
+              << std::setw(10) << "p50 ms"
+              << std::setw(10) << "p90 ms"
+              << std::setw(10) << "p99 ms"
+              << std::setw(10) << "p99.9 ms"
+              << std::setw(10) << "max ms"
+              << std::setw(8) << "2xx"
+              << std::setw(8) << "503"
+              << std::setw(8) << "other"
+              << std::setw(8) << "failed"
+              << std::setw(9) << "connects" << std::endl;
+}
+
+void printRow(const Target& target, double rate, RunResult& result) {
+    std::sort(result.latenciesMs.begin(), result.latenciesMs.end());
+
+    size_t ok = 0;
+    size_t rejected = 0;
+    size_t other = 0;
+    size_t failed = 0;
+    for (const auto& entry : result.statusCounts) {
+        if (entry.first < 0) failed += entry.second;
+        else if (entry.first >= 200 && entry.first < 300) ok += entry.second;
+        else if (entry.first == 503) rejected += entry.second;
+        else other += entry.second;
+    }
+
+    std::string rateLabel = rate > 0 ? std::to_string(static_cast<long>(rate)) : "closed";
+
+    std::cout << std::left << std::setw(10) << target.name
+              << std::right << std::setw(10) << rateLabel
+              << std::fixed << std::setprecision(1)
+              << std::setw(10) << ok / result.elapsedSeconds
+              << std::setw(9) << result.bytesSent / result.elapsedSeconds / (1024 * 1024)
+              << std::setprecision(2)
+              << std::setw(10) << percentile(result.latenciesMs, 50)
+              << std::setw(10) << percentile(result.latenciesMs, 90)
+              << std::setw(10) << percentile(result.latenciesMs, 99)
+              << std::setw(10) << percentile(result.latenciesMs, 99.9)
+              << std::setw(10) << (result.latenciesMs.empty() ? 0 : result.latenciesMs.back())
+              << std::setw(8) << ok
+              << std::setw(8) << rejected
+              << std::setw(8) << other
+              << std::setw(8) << failed
+              << std::setw(9) << result.connects << std::endl;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --target name=host:port   server to load (repeatable; default local=127.0.0.1:8081)\n"
+              << "  --concurrency N           connections per run (default 8)\n"
+              << "  --duration S              seconds per run (default 10)\n"
+              << "  --rate R[,R...]           open-loop requests/s overall, one run each;\n"
+              << "                            0 runs closed loop (default 0)\n"
+              << "  --mix size:weight[,...]   custom payload sizes in bytes (default 256:1)\n"
+              << "  --custom-share F          fraction of requests to /api/compress/custom,\n"
+              << "                            the rest go to /api/compress (default 1.0)\n"
+              << "  --repeat-ratio F          fraction of custom requests that resend a body\n"
+              << "                            already sent, to exercise result caches;\n"
+              << "                            all others are unique (default 0)\n"
+              << "  --no-keepalive            open a new connection for every request\n";
+}
+
+bool parseTarget(const std::string& spec, Target& target) {
+    size_t equals = spec.find('=');
+    std::string address = equals == std::string::npos ? spec : spec.substr(equals + 1);
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+
+    target.host = address.substr(0, colon);
+    target.port = address.substr(colon + 1);
+    target.name = equals == std::string::npos ? address : spec.substr(0, equals);
+    return !target.host.empty() && !target.port.empty();
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        if (comma > start) items.push_back(text.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--target" && hasValue) {
+            Target target;
+            if (!parseTarget(argv[++i], target)) return false;
+            options.targets.push_back(target);
+        } else if (arg == "--concurrency" && hasValue) {
+            options.concurrency = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--duration" && hasValue) {
+            options.duration = std::atof(argv[++i]);
+        } else if (arg == "--rate" && hasValue) {
+            options.rates.clear();
+            for (const std::string& item : splitList(argv[++i])) {
+                options.rates.push_back(std::atof(item.c_str()));
+            }
+        } else if (arg == "--mix" && hasValue) {
+            options.mix.clear();
+            for (const std::string& item : splitList(argv[++i])) {
+                size_t colon = item.find(':');
+                PayloadClass payload;
+                payload.size = std::strtoul(item.c_str(), nullptr, 10);
+                payload.weight = colon == std::string::npos ? 1 : std::atoi(item.c_str() + colon + 1);
+                if (payload.size == 0 || payload.weight <= 0) return false;
+                options.mix.push_back(payload);
+            }
+        } else if (arg == "--custom-share" && hasValue) {
+            options.customShare = std::atof(argv[++i]);
+        } else if (arg == "--repeat-ratio" && hasValue) {
+            options.repeatRatio = std::atof(argv[++i]);
+        } else if (arg == "--no-keepalive") {
+            options.keepAlive = false;
+        } else {
+            return false;
+        }
+    }
+
+    if (options.targets.empty()) {
+        options.targets.push_back({"local", "127.0.0.1", "8081"});
+    }
+    return !options.rates.empty() && !options.mix.empty() && options.duration > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::cerr << "WSAStartup failed" << std::endl;
+        return 1;
+    }
+#endif
+
+    std::cout << "Connections: " << options.concurrency
+              << ", duration: " << options.duration << "s per run"
+              << ", keep-alive: " << (options.keepAlive ? "on" : "off") << std::endl;
+    std::cout << "Open-loop latency is measured from each request's scheduled send time" << std::endl;
+    printHeader();
+
+    // Interleave targets at each rate so they are compared side by side
+    for (double rate : options.rates) {
+        for (const Target& target : options.targets) {
+            RunResult result = runLoad(target, options, rate);
+            printRow(target, rate, result);
+        }
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include "result_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const uint64_t PRIME1 = 11400714785074694791ULL;
+    const uint64_t PRIME2 = 14029467366897019727ULL;
+    const uint64_t PRIME3 = 1609587929392839161ULL;
+    const uint64_t PRIME4 = 9650029242287828579ULL;
+    const uint64_t PRIME5 = 2870177450012600261ULL;
+
+    // Bookkeeping cost charged per entry on top of its strings
+    const size_t ENTRY_OVERHEAD = 128;
+
+    inline uint64_t rotl(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t read64(const unsigned char* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t read32(const unsigned char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * PRIME2;
+        acc = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+        acc ^= round(0, value);
+        return acc * PRIME1 + PRIME4;
+    }
+
+    inline uint64_t avalanche(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= PRIME2;
+        hash ^= hash >> 29;
+        hash *= PRIME3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
+
+uint64_t xxhash64(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t hash;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME5;
+    }
+
+    hash += static_cast<uint64_t>(size);
+
+    while (p + 8 <= end) {
+        hash ^= round(0, read64(p));
+        hash = rotl(hash, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        hash ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+        hash = rotl(hash, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+
+    while (p < end) {
+        hash ^= (*p) * PRIME5;
+        hash = rotl(hash, 11) * PRIME1;
+        p++;
+    }
+
+    return avalanche(hash);
+}
+
+ResultCache::ResultCache(size_t budgetBytes, size_t shardCount) :
+    hits(0),
+    misses(0),
+    insertions(0),
+    evictions(0) {
+    // Round the shard count up to a power of two so a mask picks the shard
+    size_t count = 1;
+    while (count < shardCount) {
+        count <<= 1;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        shards.emplace_back(new Shard());
+    }
+    shardMask = count - 1;
+    shardBudget = budgetBytes / count;
+}
+
+ResultCache::Shard& ResultCache::shardFor(uint64_t key) {
+    // High bits pick the shard; the shard's hash map consumes the low bits
+    return *shards[(key >> 48) & shardMask];
+}
+
+bool ResultCache::lookup(uint64_t key, const std::string& payload, CodecResults& results) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end() || it->second->payload != payload) {
+        return false;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    results = it->second->results;
+    return true;
+}
+
+void ResultCache::insert(uint64_t key, const std::string& payload, const CodecResults& results) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Start from the payload's entry so results another request added
+    // meanwhile are kept; a colliding payload's entry is replaced
+    Entry entry{key, std::string(), {}, 0};
+    bool reused = false;
+    auto existing = shard.index.find(key);
+    if (existing != shard.index.end()) {
+        if (existing->second->payload == payload) {
+            entry.payload = std::move(existing->second->payload);
+            entry.results = std::move(existing->second->results);
+            reused = true;
+        }
+        shard.bytes -= existing->second->bytes;
+        shard.lru.erase(existing->second);
+        shard.index.erase(existing);
+    }
+    if (!reused) {
+        entry.payload = payload;
+    }
+
+    for (const auto& result : results) {
+        auto same = std::find_if(entry.results.begin(), entry.results.end(),
+            [&result](const std::pair<std::string, Result>& cached) {
+                return cached.first == result.first;
+            });
+        if (same == entry.results.end()) {
+            entry.results.push_back(result);
+        } else {
+            same->second = result.second;
+        }
+    }
+
+    entry.bytes = entry.payload.size() + ENTRY_OVERHEAD;
+    for (const auto& result : entry.results) {
+        entry.bytes += result.first.size() + sizeof(Result);
+    }
+    if (entry.bytes > shardBudget) {
+        return;
+    }
+
+    while (!shard.lru.empty() && shard.bytes + entry.bytes > shardBudget) {
+        Entry& victim = shard.lru.back();
+        shard.bytes -= victim.bytes;
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.bytes += entry.bytes;
+    shard.lru.push_front(std::move(entry));
+    shard.index[key] = shard.lru.begin();
+    insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+ResultCache::Session::Session(ResultCache& cache, const std::string& payload) :
+    cache(cache),
+    payload(payload),
+    payloadHash(xxhash64(payload.data(), payload.size())) {
+    cache.lookup(payloadHash, payload, results);
+}
+
+void ResultCache::Session::commit() {
+    if (computed) {
+        cache.insert(payloadHash, payload, results);
+        computed = false;
+    }
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    Stats snapshot;
+    snapshot.hits = hits.load(std::memory_order_relaxed);
+    snapshot.misses = misses.load(std::memory_order_relaxed);
+    snapshot.insertions = insertions.load(std::memory_order_relaxed);
+    snapshot.evictions = evictions.load(std::memory_order_relaxed);
+    snapshot.bytes = 0;
+    snapshot.entries = 0;
+
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        snapshot.bytes += shard->bytes;
+        snapshot.entries += shard->lru.size();
+    }
+
+    return snapshot;
+}
+
+void ResultCache::clear() {
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->lru.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
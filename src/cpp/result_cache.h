@@ -0,0 +1,121 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// XXH64 of size bytes at data
+uint64_t xxhash64(const void* data, size_t size, uint64_t seed = 0);
+
+// Content-addressed cache of compression results.
+//
+// Devices resend identical heartbeat and status frames, so results are keyed
+// by a 64-bit hash of the payload. Each entry holds the payload once, plus a
+// small map from codec name to the size and ratio of its result (not the
+// compressed output). A request opens a Session, which hashes the payload
+// and finds its entry once, then serves every codec the request runs from
+// that copy. The cache is split into independently locked shards, each an
+// LRU list bounded by its share of the byte budget. The stored payload is
+// compared on lookup so a hash collision is a miss rather than returning
+// the wrong result.
+class ResultCache {
+public:
+    struct Result {
+        size_t compressedSize;  // bits
+        double ratio;
+    };
+
+    // Results for one payload by codec name. Only a handful of codecs run
+    // per payload, so a vector searched linearly is the map.
+    typedef std::vector<std::pair<std::string, Result>> CodecResults;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t insertions;
+        uint64_t evictions;
+        size_t bytes;
+        size_t entries;
+    };
+
+    ResultCache(size_t budgetBytes, size_t shardCount = 16);
+
+    // One request's use of the cache. The payload is hashed, looked up and
+    // compared once when the session opens, and stored at most once by
+    // commit(), however many codecs run in between.
+    class Session {
+    public:
+        Session(ResultCache& cache, const std::string& payload);
+
+        // Return the cached result, or run compute() and keep what it returns
+        template<class F>
+        Result getOrCompute(const std::string& codec, F&& compute) {
+            for (const auto& cached : results) {
+                if (cached.first == codec) {
+                    cache.hits.fetch_add(1, std::memory_order_relaxed);
+                    return cached.second;
+                }
+            }
+            cache.misses.fetch_add(1, std::memory_order_relaxed);
+
+            Result result = compute();
+            results.emplace_back(codec, result);
+            computed = true;
+            return result;
+        }
+
+        // Store the results computed in this session; a no-op if all hit
+        void commit();
+
+    private:
+        ResultCache& cache;
+        const std::string& payload;
+        uint64_t payloadHash;
+        CodecResults results;
+        bool computed = false;
+    };
+
+    Stats stats() const;
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::string payload;
+        CodecResults results;
+        size_t bytes;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;  // most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    Shard& shardFor(uint64_t key);
+
+    // Copy the cached results for payload; false if it has no entry
+    bool lookup(uint64_t key, const std::string& payload, CodecResults& results);
+
+    // Merge results into the payload's entry, creating it if needed
+    void insert(uint64_t key, const std::string& payload, const CodecResults& results);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardMask;
+    size_t shardBudget;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> insertions;
+    std::atomic<uint64_t> evictions;
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,110 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Simple Thread Pool
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    std::atomic<bool> stop;
+    std::atomic<size_t> pending;  // queued plus running tasks
+
+    struct PendingGuard {
+        std::atomic<size_t>& pending;
+        explicit PendingGuard(std::atomic<size_t>& pending) : pending(pending) {}
+        ~PendingGuard() { pending.fetch_sub(1); }
+    };
+
+public:
+    ThreadPool(size_t numThreads) : stop(false), pending(0) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+                        this->condition.wait(lock, [this] {
+                            return this->stop || !this->tasks.empty();
+                        });
+
+                        if (this->stop && this->tasks.empty()) {
+                            return;
+                        }
+
+                        task = std::move(this->tasks.front());
+                        this->tasks.pop();
+                    }
+                    // Release the admission slot even if the task throws, and
+                    // keep the worker alive: an exception escaping a thread
+                    // would terminate the process
+                    PendingGuard guard(this->pending);
+                    try {
+                        task();
+                    } catch (const std::exception& e) {
+                        std::cerr << "Thread pool task failed: " << e.what() << std::endl;
+                    } catch (...) {
+                        std::cerr << "Thread pool task failed" << std::endl;
+                    }
+                }
+            });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    template<class F>
+    void enqueue(F&& f) {
+        pending.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            tasks.emplace(std::forward<F>(f));
+        }
+        condition.notify_one();
+    }
+
+    // Enqueue only while fewer than maxPending tasks are queued or running.
+    // Returns false when the pool is saturated so callers can shed load.
+    template<class F>
+    bool tryEnqueue(F&& f, size_t maxPending) {
+        size_t current = pending.load();
+        do {
+            if (current >= maxPending) {
+                return false;
+            }
+        } while (!pending.compare_exchange_weak(current, current + 1));
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            tasks.emplace(std::forward<F>(f));
+        }
+        condition.notify_one();
+        return true;
+    }
+
+    size_t pendingTasks() const {
+        return pending.load();
+    }
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,125 @@
+#include "timing_wheel.h"
+
+TimingWheel::TimingWheel(uint64_t startTick) :
+    current(startTick),
+    heads(LEVELS * SLOTS, INVALID_ID),
+    active(0) {}
+
+void TimingWheel::schedule(uint32_t id, uint64_t expiresTick) {
+    if (id >= timers.size()) {
+        timers.resize(id + 1);
+    }
+
+    if (timers[id].slot != INVALID_ID) {
+        unlink(id);
+    }
+
+    // The current tick has already been processed, so the earliest a new
+    // timer can fire is the next one
+    timers[id].expires = expiresTick;
+    link(id, current + 1);
+}
+
+void TimingWheel::cancel(uint32_t id) {
+    if (isScheduled(id)) {
+        unlink(id);
+    }
+}
+
+bool TimingWheel::isScheduled(uint32_t id) const {
+    return id < timers.size() && timers[id].slot != INVALID_ID;
+}
+
+// Place a timer in the finest level whose range covers its expiry. The
+// level-0 slots hold the next 256 ticks; each coarser level covers 256
+// times the range of the one below it.
+void TimingWheel::link(uint32_t id, uint64_t earliest) {
+    Timer& timer = timers[id];
+
+    uint64_t expires = timer.expires > earliest ? timer.expires : earliest;
+    uint64_t delta = expires - current;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+
+    // Beyond the wheel's range: park in the furthest slot and let it
+    // cascade back in when that slot comes round
+    if (delta >= (uint64_t(1) << (SLOT_BITS * LEVELS))) {
+        expires = current + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+    }
+
+    uint32_t slot = level * SLOTS + static_cast<uint32_t>((expires >> (SLOT_BITS * level)) & SLOT_MASK);
+
+    timer.slot = slot;
+    timer.prev = INVALID_ID;
+    timer.next = heads[slot];
+    if (timer.next != INVALID_ID) {
+        timers[timer.next].prev = id;
+    }
+    heads[slot] = id;
+    active++;
+}
+
+void TimingWheel::unlink(uint32_t id) {
+    Timer& timer = timers[id];
+
+    if (timer.prev != INVALID_ID) {
+        timers[timer.prev].next = timer.next;
+    } else {
+        heads[timer.slot] = timer.next;
+    }
+    if (timer.next != INVALID_ID) {
+        timers[timer.next].prev = timer.prev;
+    }
+
+    timer.prev = INVALID_ID;
+    timer.next = INVALID_ID;
+    timer.slot = INVALID_ID;
+    active--;
+}
+
+// Re-file every timer in a coarse slot now that its range has been reached
+void TimingWheel::cascade(int level, uint32_t index) {
+    uint32_t slot = level * SLOTS + index;
+    uint32_t id = heads[slot];
+    heads[slot] = INVALID_ID;
+
+    while (id != INVALID_ID) {
+        uint32_t next = timers[id].next;
+        timers[id].slot = INVALID_ID;
+        active--;
+        // Cascading happens before the current tick's slot fires, so
+        // timers due now still make it
+        link(id, current);
+        id = next;
+    }
+}
+
+void TimingWheel::advance(uint64_t nowTick, const std::function<void(uint32_t)>& onExpire) {
+    while (current < nowTick) {
+        // Nothing pending: skip straight to the target tick
+        if (active == 0) {
+            current = nowTick;
+            break;
+        }
+
+        current++;
+
+        for (int level = 1; level < LEVELS; level++) {
+            if (current & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) {
+                break;
+            }
+            cascade(level, static_cast<uint32_t>((current >> (SLOT_BITS * level)) & SLOT_MASK));
+        }
+
+        // Unlink before calling out, so callbacks may re-arm the timer
+        uint32_t slot = static_cast<uint32_t>(current & SLOT_MASK);
+        while (heads[slot] != INVALID_ID) {
+            uint32_t id = heads[slot];
+            unlink(id);
+            onExpire(id);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Hierarchical timing wheel.
+//
+// Four levels of 256 slots each cover 2^32 ticks. Scheduling and cancelling
+// are O(1); advancing costs O(1) per tick plus the timers that fire or
+// cascade to a finer level. Timers are identified by small integer ids
+// (callers index their own state by them) and stored in an intrusive
+// doubly linked list per slot, so no allocation happens once the id range
+// has been reserved.
+class TimingWheel {
+public:
+    static constexpr uint32_t INVALID_ID = 0xFFFFFFFFu;
+
+    explicit TimingWheel(uint64_t startTick = 0);
+
+    // (Re)arm timer id to fire at the given tick; past ticks fire on the
+    // next advance
+    void schedule(uint32_t id, uint64_t expiresTick);
+    void cancel(uint32_t id);
+    bool isScheduled(uint32_t id) const;
+
+    // Move time forward to nowTick, calling onExpire(id) for every timer
+    // that came due
+    void advance(uint64_t nowTick, const std::function<void(uint32_t)>& onExpire);
+
+    uint64_t currentTick() const { return current; }
+
+private:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 8;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t SLOT_MASK = SLOTS - 1;
+
+    struct Timer {
+        uint64_t expires = 0;
+        uint32_t prev = INVALID_ID;
+        uint32_t next = INVALID_ID;
+        uint32_t slot = INVALID_ID;  // index into heads, INVALID_ID if idle
+    };
+
+    void link(uint32_t id, uint64_t earliest);
+    void unlink(uint32_t id);
+    void cascade(int level, uint32_t index);
+
+    uint64_t current;
+    std::vector<uint32_t> heads;  // LEVELS * SLOTS list heads
+    std::vector<Timer> timers;
+    size_t active;  // timers currently linked into a slot
+};
+
+#endif // TIMING_WHEEL_H
@@ -0,0 +1,63 @@
+// Offline trainer for the per-class shared dictionaries.
+//
+// Reads "<samples>/<class>.txt" (one sample frame per line) for every device
+// class present, trains a dictionary from it and writes
+// "<output>/<class>.dict", which the Crow server loads at startup.
+//
+// Example: train from the bundled samples into the server's default directory
+//   ./train_dictionary samples dictionaries
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "dictionary.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <samples-dir> <output-dir>" << std::endl;
+        return 1;
+    }
+
+    std::string samplesDir = argv[1];
+    std::string outputDir = argv[2];
+    size_t trained = 0;
+
+    for (size_t i = 0; i < Dictionary::DEVICE_CLASS_COUNT; i++) {
+        Dictionary::DeviceClass deviceClass = static_cast<Dictionary::DeviceClass>(i);
+        std::string className = Dictionary::deviceClassName(deviceClass);
+
+        std::ifstream file(samplesDir + "/" + className + ".txt");
+        if (!file) {
+            continue;
+        }
+
+        std::vector<std::string> samples;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) {
+                samples.push_back(line);
+            }
+        }
+        if (samples.empty()) {
+            std::cerr << "No samples for " << className << ", skipped" << std::endl;
+            continue;
+        }
+
+        Dictionary::Trained dictionary = Dictionary::train(samples);
+        std::string path = outputDir + "/" + className + ".dict";
+        if (!Dictionary::save(dictionary, path)) {
+            std::cerr << "Failed to write " << path << std::endl;
+            return 1;
+        }
+
+        std::cout << className << ": " << samples.size() << " samples -> "
+                  << dictionary.content.size() << " bytes in " << path << std::endl;
+        trained++;
+    }
+
+    if (trained == 0) {
+        std::cerr << "No sample files found in " << samplesDir << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -12,6 +12,7 @@
 #include <chrono>
 #include <random>
 #include "compression_algorithms.h"
+#include "thread_pool.h"
 using namespace std;
 #ifdef _WIN32
     #include <winsock2.h>
@@ -30,61 +31,6 @@ using namespace std;
     typedef int SocketType;
 #endif
 
-// Simple Thread Pool
-class ThreadPool {
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    std::atomic<bool> stop;
-
-public:
-    ThreadPool(size_t numThreads) : stop(false) {
-        for (size_t i = 0; i < numThreads; ++i) {
-            workers.emplace_back([this] {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock, [this] { 
-                            return this->stop || !this->tasks.empty(); 
-                        });
-                        
-                        if (this->stop && this->tasks.empty()) {
-                            return;
-                        }
-                        
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
-                }
-            });
-        }
-    }
-
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (std::thread &worker : workers) {
-            worker.join();
-        }
-    }
-
-    template<class F>
-    void enqueue(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            tasks.emplace(std::forward<F>(f));
-        }
-        condition.notify_one();
-    }
-};
-
 // Simple HTTP Server
 class HttpServer {
 private:
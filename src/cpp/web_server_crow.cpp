@@ -2,7 +2,21 @@
 #include <string>
 #include <random>
 #include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <shared_mutex>
+#include <unordered_map>
+#include "aggregation.h"
+#include "batch_scheduler.h"
 #include "compression_algorithms.h"
+#include "result_cache.h"
+#include "thread_pool.h"
 #include "crow.h"  // Crow is a header-only library
 
 // Generate random IoT-like data for simulation
@@ -21,6 +35,123 @@ std::string generateIoTData(int size) {
     return data;
 }
 
+// Payloads up to this size are compressed directly on the I/O thread; the
+// hand-off costs more than the work
+const size_t INLINE_THRESHOLD_BYTES = 16 * 1024;
+
+// Offloaded requests queued or running before new ones are refused with 503
+const size_t MAX_PENDING_OFFLOADS = 64;
+
+// Status code and serialized JSON body of a compression request
+struct Reply {
+    int code;
+    std::string body;
+};
+
+void sendReply(crow::response& res, const Reply& reply) {
+    res.code = reply.code;
+    res.set_header("Content-Type", "application/json");
+    res.write(reply.body);
+    res.end();
+}
+
+Reply errorReply(int code, const std::string& message) {
+    crow::json::wvalue error;
+    error["error"] = message;
+    return {code, error.dump()};
+}
+
+// Reduce a codec's output to what the API reports. Huffman returns one
+// character per bit, the other codecs return bytes.
+ResultCache::Result summarize(const std::pair<std::string, double>& result, size_t bitsPerUnit) {
+    return {result.first.size() * bitsPerUnit, result.second};
+}
+
+crow::json::wvalue resultJson(const std::string& algorithm, const ResultCache::Result& result) {
+    crow::json::wvalue json;
+    json["algorithm"] = algorithm;
+    json["compressionRatio"] = result.ratio;
+    json["compressedSize"] = result.compressedSize;
+    return json;
+}
+
+// Parse, compress and serialize a /api/compress/custom request body. Touches
+// no connection state, so it can run on the I/O thread or the compute pool.
+Reply compressCustomData(const std::string& body, const Dictionary::Registry& dictionaries,
+                         ResultCache& resultCache) {
+    auto jsonData = crow::json::load(body);
+    
+    // Check if the JSON parsing was successful and contains the 'data' field
+    if (!jsonData || !jsonData.has("data")) {
+        return errorReply(400, "Invalid request format. Expected JSON with 'data' field.");
+    }
+    
+    // Get the data from the request
+    std::string userData = jsonData["data"].s();
+    
+    if (userData.empty()) {
+        return errorReply(400, "Data cannot be empty.");
+    }
+    
+    // Run compression algorithms on user data; the session looks the
+    // payload up once and serves every codec below from that entry
+    ResultCache::Session cached(resultCache, userData);
+    auto resultHuffman = cached.getOrCompute("huffman", [&userData]() {
+        return summarize(Huffman::compress(userData), 1);
+    });
+    auto resultDelta = cached.getOrCompute("delta", [&userData]() {
+        return summarize(Delta::compress(userData), 8);
+    });
+    
+    std::vector<crow::json::wvalue> results;
+    results.push_back(resultJson("huffman", resultHuffman));
+    results.push_back(resultJson("delta", resultDelta));
+    
+    // Optionally prime with the shared dictionary for the device class
+    Dictionary::DeviceClass deviceClass;
+    if (jsonData.has("deviceType") &&
+        Dictionary::parseDeviceClass(jsonData["deviceType"].s(), deviceClass)) {
+        if (auto dictionary = dictionaries.find(deviceClass)) {
+            std::string className = Dictionary::deviceClassName(deviceClass);
+            auto resultHuffmanDict = cached.getOrCompute("huffman-dict:" + className, [&]() {
+                return summarize(Huffman::compress(userData, *dictionary), 1);
+            });
+            auto resultLZ77Dict = cached.getOrCompute("lz77-dict:" + className, [&]() {
+                return summarize(LZ77::compress(userData, *dictionary), 8);
+            });
+            
+            results.push_back(resultJson("huffman-dict", resultHuffmanDict));
+            results.push_back(resultJson("lz77-dict", resultLZ77Dict));
+        }
+    }
+    
+    // Store what was computed before userData is moved out below
+    cached.commit();
+    
+    // Create JSON response; userData is no longer needed, so move it in
+    crow::json::wvalue response;
+    response["originalSize"] = userData.size();
+    response["originalData"] = std::move(userData);
+    response["results"] = std::move(results);
+    
+    return {200, response.dump()};
+}
+
+// Define CORS headers middleware. The headers are set after the handler:
+// a handler's returned response replaces the one before_handle sees, and
+// asynchronous handlers only finish at res.end(), which runs after_handle.
+struct CORSMiddleware {
+    struct context {};
+    
+    void before_handle(crow::request& req, crow::response& res, context& ctx) {}
+    
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        res.set_header("Access-Control-Allow-Origin", "*");
+        res.set_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+        res.set_header("Access-Control-Allow-Headers", "Content-Type");
+    }
+};
+
 int main(int argc, char* argv[]) {
     // Parse command line arguments for port
     int port = 8081;
@@ -28,28 +159,68 @@ int main(int argc, char* argv[]) {
         port = std::atoi(argv[1]);
     }
     
-    // Create Crow application
-    crow::SimpleApp app;
+    // Load shared dictionaries once; the registry is read-only from here on,
+    // so every handler thread can use it without locking
+    std::string dictionaryDir = "dictionaries";
+    if (argc > 2) {
+        dictionaryDir = argv[2];
+    }
+    Dictionary::Registry dictionaries;
+    size_t loadedDictionaries = dictionaries.loadDirectory(dictionaryDir);
+    std::cout << "Loaded " << loadedDictionaries << " dictionaries from " << dictionaryDir << std::endl;
+    
+    // Devices resend identical frames, so compression results are cached by
+    // payload content across all handler threads
+    ResultCache resultCache(64 * 1024 * 1024);
     
-    // Configure CORS
-    crow::SimpleApp::LogLevel logLevel = crow::LogLevel::INFO;
-    app.loglevel(logLevel);
+    // Create Crow application with the CORS middleware
+    crow::App<CORSMiddleware> app;
     
-    // Define CORS headers middleware
-    struct CORSMiddleware {
-        struct context {};
-        
-        void before_handle(crow::request& req, crow::response& res, context& ctx) {
-            res.add_header("Access-Control-Allow-Origin", "*");
-            res.add_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-            res.add_header("Access-Control-Allow-Headers", "Content-Type");
+    // Compression work offloaded from Crow's I/O threads. Declared after the
+    // app so it is joined while the app's io_service is still alive.
+    ThreadPool computePool(std::max(1u, std::thread::hardware_concurrency()));
+    
+    // Frames posted to /api/ingest are batched per device and compressed
+    // once per batch, primed with the device class dictionary when present.
+    // The server is the end of the line for them: it keeps each device's
+    // most recent compressed batch for /api/batch/latest and counts the rest.
+    std::atomic<uint64_t> batchesFlushed(0);
+    std::atomic<uint64_t> framesFlushed(0);
+    std::atomic<uint64_t> batchBytesIn(0);
+    std::atomic<uint64_t> batchBytesOut(0);
+    std::atomic<uint64_t> framesRejected(0);
+    std::unordered_map<std::string, BatchScheduler::Batch> latestBatches;
+    std::mutex latestBatchesMutex;
+    
+    BatchScheduler batchScheduler(
+        [&dictionaries](Dictionary::DeviceClass deviceClass, const std::string& batch) {
+            if (auto dictionary = dictionaries.find(deviceClass)) {
+                return LZ77::compress(batch, *dictionary);
+            }
+            return LZ77::compress(batch);
+        },
+        [&](const BatchScheduler::Batch& batch) {
+            batchesFlushed++;
+            framesFlushed += batch.frameCount;
+            batchBytesIn += batch.originalSize;
+            batchBytesOut += batch.result.first.size();
+            
+            std::lock_guard<std::mutex> lock(latestBatchesMutex);
+            latestBatches[batch.deviceId] = batch;
+        });
+    
+    // Full buffers and latency deadlines are compressed here, never on
+    // Crow's I/O threads; a full buffer waits at most one polling interval
+    std::atomic<bool> schedulerRunning(true);
+    std::thread schedulerThread([&batchScheduler, &schedulerRunning]() {
+        while (schedulerRunning) {
+            batchScheduler.poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
         }
-        
-        void after_handle(crow::request& req, crow::response& res, context& ctx) {}
-    };
+        batchScheduler.flushAll();
+    });
     
-    // Add the CORS middleware
-    app.use<CORSMiddleware>();
+    app.loglevel(crow::LogLevel::Info);
     
     // Define the compression endpoint for auto-generated data
     CROW_ROUTE(app, "/api/compress")
@@ -65,87 +236,244 @@ int main(int argc, char* argv[]) {
         crow::json::wvalue response;
         response["originalSize"] = testData.size();
         
-        crow::json::wvalue results;
-        
-        crow::json::wvalue huffman;
-        huffman["algorithm"] = "huffman";
-        huffman["compressionRatio"] = resultHuffman.second;
-        huffman["compressedSize"] = resultHuffman.first.size();
-        
-        crow::json::wvalue delta;
-        delta["algorithm"] = "delta";
-        delta["compressionRatio"] = resultDelta.second;
-        delta["compressedSize"] = resultDelta.first.size() * 8;
-        
-        results.push_back(std::move(huffman));
-        results.push_back(std::move(delta));
+        std::vector<crow::json::wvalue> results;
+        results.push_back(resultJson("huffman", summarize(resultHuffman, 1)));
+        results.push_back(resultJson("delta", summarize(resultDelta, 8)));
         
         response["results"] = std::move(results);
         
         return response;
     });
     
-    // Define the compression endpoint for user data
+    // Define the compression endpoint for user data. Small payloads are
+    // compressed inline; larger ones are handed to the compute pool so they
+    // do not stall the I/O thread and every connection multiplexed on it.
     CROW_ROUTE(app, "/api/compress/custom")
     .methods("POST"_method)
+    ([&dictionaries, &resultCache, &computePool](const crow::request& req, crow::response& res) {
+        if (req.body.size() <= INLINE_THRESHOLD_BYTES) {
+            sendReply(res, compressCustomData(req.body, dictionaries, resultCache));
+            return;
+        }
+        
+        // The connection owns req and res until res.end(), and the request
+        // object itself is not const; post() just needs mutable access
+        crow::request* request = const_cast<crow::request*>(&req);
+        crow::response* response = &res;
+        
+        bool admitted = computePool.tryEnqueue([request, response, &dictionaries, &resultCache]() {
+            // Crow's json accessors throw on unexpected types (e.g. a numeric
+            // 'data'). Crow only catches that on its own threads, so catch it
+            // here and still complete the response.
+            auto reply = std::make_shared<Reply>();
+            try {
+                *reply = compressCustomData(request->body, dictionaries, resultCache);
+            } catch (const std::exception& e) {
+                *reply = errorReply(400, std::string("Invalid request: ") + e.what());
+            }
+            
+            // Crow connections are not thread-safe; complete on the I/O thread
+            request->post([response, reply]() {
+                sendReply(*response, *reply);
+            });
+        }, MAX_PENDING_OFFLOADS);
+        
+        if (!admitted) {
+            res.add_header("Retry-After", "1");
+            sendReply(res, errorReply(503, "Server is overloaded, retry later."));
+        }
+    });
+    
+    // Add an OPTIONS route for CORS preflight requests
+    CROW_ROUTE(app, "/api/compress/custom")
+    .methods("OPTIONS"_method)
     ([](const crow::request& req) {
+        // The CORS headers are added by CORSMiddleware
+        crow::response res;
+        res.code = 204; // No content
+        return res;
+    });
+    
+    // Accept a single device frame for batched compression
+    CROW_ROUTE(app, "/api/ingest")
+    .methods("POST"_method)
+    ([&batchScheduler, &framesRejected](const crow::request& req) {
         auto jsonData = crow::json::load(req.body);
         
-        // Check if the JSON parsing was successful and contains the 'data' field
-        if (!jsonData || !jsonData.has("data")) {
+        Dictionary::DeviceClass deviceClass;
+        if (!jsonData || !jsonData.has("deviceId") || !jsonData.has("deviceType") || !jsonData.has("data") ||
+            !Dictionary::parseDeviceClass(jsonData["deviceType"].s(), deviceClass)) {
             crow::json::wvalue error;
-            error["error"] = "Invalid request format. Expected JSON with 'data' field.";
+            error["error"] = "Expected JSON with 'deviceId', 'deviceType' and 'data' fields.";
             return crow::response(400, error);
         }
         
-        // Get the data from the request
-        std::string userData = jsonData["data"].s();
+        if (!batchScheduler.submit(jsonData["deviceId"].s(), deviceClass, jsonData["data"].s())) {
+            // Compression is behind and the queue of full batches is at its limit
+            framesRejected++;
+            crow::json::wvalue error;
+            error["error"] = "Server is overloaded, retry later.";
+            crow::response res(503, error);
+            res.add_header("Retry-After", "1");
+            return res;
+        }
         
-        if (userData.empty()) {
+        crow::response res;
+        res.code = 202; // Accepted, compressed with the next batch
+        return res;
+    });
+    
+    // Per-device telemetry series, queryable without decompressing them
+    std::unordered_map<std::string, std::unique_ptr<Aggregation::SeriesStore>> telemetry;
+    std::shared_mutex telemetryMutex;
+    
+    // Append a fixed-point sample to a device's series
+    CROW_ROUTE(app, "/api/telemetry")
+    .methods("POST"_method)
+    ([&telemetry, &telemetryMutex](const crow::request& req) {
+        auto jsonData = crow::json::load(req.body);
+        
+        if (!jsonData || !jsonData.has("deviceId") || !jsonData.has("timestamp") || !jsonData.has("value")) {
             crow::json::wvalue error;
-            error["error"] = "Data cannot be empty.";
+            error["error"] = "Expected JSON with 'deviceId', 'timestamp' and 'value' fields.";
             return crow::response(400, error);
         }
         
-        // Run compression algorithms on user data
-        auto resultHuffman = Huffman::compress(userData);
-        auto resultDelta = Delta::compress(userData);
+        std::string deviceId = jsonData["deviceId"].s();
+        Aggregation::SeriesStore* store;
+        {
+            std::shared_lock<std::shared_mutex> lock(telemetryMutex);
+            auto it = telemetry.find(deviceId);
+            store = it == telemetry.end() ? nullptr : it->second.get();
+        }
+        if (!store) {
+            std::unique_lock<std::shared_mutex> lock(telemetryMutex);
+            auto& slot = telemetry[deviceId];
+            if (!slot) {
+                slot.reset(new Aggregation::SeriesStore());
+            }
+            store = slot.get();
+        }
         
-        // Create JSON response
-        crow::json::wvalue response;
-        response["originalSize"] = userData.size();
-        response["originalData"] = userData;
+        if (!store->append(jsonData["timestamp"].u(), jsonData["value"].i())) {
+            crow::json::wvalue error;
+            error["error"] = "Timestamps must not decrease.";
+            return crow::response(409, error);
+        }
         
-        crow::json::wvalue results;
+        crow::response res;
+        res.code = 204; // No content
+        return res;
+    });
+    
+    // min/max/sum/count/avg over a device's samples in [from, to]
+    CROW_ROUTE(app, "/api/telemetry/query")
+    ([&telemetry, &telemetryMutex](const crow::request& req) {
+        const char* deviceId = req.url_params.get("deviceId");
+        const char* from = req.url_params.get("from");
+        const char* to = req.url_params.get("to");
         
-        crow::json::wvalue huffman;
-        huffman["algorithm"] = "huffman";
-        huffman["compressionRatio"] = resultHuffman.second;
-        huffman["compressedSize"] = resultHuffman.first.size();
+        if (!deviceId || !from || !to) {
+            crow::json::wvalue error;
+            error["error"] = "Expected 'deviceId', 'from' and 'to' query parameters.";
+            return crow::response(400, error);
+        }
         
-        crow::json::wvalue delta;
-        delta["algorithm"] = "delta";
-        delta["compressionRatio"] = resultDelta.second;
-        delta["compressedSize"] = resultDelta.first.size() * 8;
+        Aggregation::Result result;
+        {
+            std::shared_lock<std::shared_mutex> lock(telemetryMutex);
+            auto it = telemetry.find(deviceId);
+            if (it != telemetry.end()) {
+                result = it->second->query(std::strtoull(from, nullptr, 10), std::strtoull(to, nullptr, 10));
+            }
+        }
         
-        results.push_back(std::move(huffman));
-        results.push_back(std::move(delta));
+        crow::json::wvalue response;
+        response["count"] = result.count;
+        response["min"] = result.min;
+        response["max"] = result.max;
+        response["sum"] = result.sum;
+        response["avg"] = result.average();
+        response["blocksFromSummary"] = result.blocksFromSummary;
+        response["blocksDecoded"] = result.blocksDecoded;
         
-        response["results"] = std::move(results);
+        return crow::response(response);
+    });
+    
+    // Report batching effectiveness
+    CROW_ROUTE(app, "/api/batch/stats")
+    ([&](const crow::request& req) {
+        crow::json::wvalue response;
+        response["devices"] = batchScheduler.deviceCount();
+        response["batches"] = batchesFlushed.load();
+        response["frames"] = framesFlushed.load();
+        response["bytesIn"] = batchBytesIn.load();
+        response["bytesOut"] = batchBytesOut.load();
+        response["queuedBytes"] = batchScheduler.queuedBytes();
+        response["rejected"] = framesRejected.load();
         
         return response;
     });
     
-    // Add an OPTIONS route for CORS preflight requests
-    CROW_ROUTE(app, "/api/compress/custom")
-    .methods("OPTIONS"_method)
-    ([](const crow::request& req) {
-        crow::response res;
-        res.add_header("Access-Control-Allow-Origin", "*");
-        res.add_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-        res.add_header("Access-Control-Allow-Headers", "Content-Type");
-        res.code = 204; // No content
-        return res;
+    // Decode a device's most recent batch back into its frames
+    CROW_ROUTE(app, "/api/batch/latest")
+    ([&](const crow::request& req) {
+        const char* deviceId = req.url_params.get("deviceId");
+        if (!deviceId) {
+            crow::json::wvalue error;
+            error["error"] = "Expected 'deviceId' query parameter.";
+            return crow::response(400, error);
+        }
+        
+        BatchScheduler::Batch batch;
+        {
+            std::lock_guard<std::mutex> lock(latestBatchesMutex);
+            auto it = latestBatches.find(deviceId);
+            if (it == latestBatches.end()) {
+                crow::json::wvalue error;
+                error["error"] = "No batch flushed for this device yet.";
+                return crow::response(404, error);
+            }
+            batch = it->second;
+        }
+        
+        std::string decoded;
+        if (auto dictionary = dictionaries.find(batch.deviceClass)) {
+            decoded = LZ77::decompress(batch.result.first, *dictionary);
+        } else {
+            decoded = LZ77::decompress(batch.result.first);
+        }
+        
+        std::vector<crow::json::wvalue> frames;
+        for (const std::string& frame : BatchScheduler::splitFrames(decoded)) {
+            frames.push_back(crow::json::wvalue(frame));
+        }
+        
+        crow::json::wvalue response;
+        response["deviceId"] = batch.deviceId;
+        response["deviceType"] = Dictionary::deviceClassName(batch.deviceClass);
+        response["originalSize"] = batch.originalSize;
+        response["compressedSize"] = batch.result.first.size();
+        response["compressionRatio"] = batch.result.second;
+        response["frames"] = std::move(frames);
+        
+        return crow::response(response);
+    });
+    
+    // Report result cache effectiveness
+    CROW_ROUTE(app, "/api/cache/stats")
+    ([&resultCache](const crow::request& req) {
+        ResultCache::Stats stats = resultCache.stats();
+        
+        crow::json::wvalue response;
+        response["hits"] = stats.hits;
+        response["misses"] = stats.misses;
+        response["insertions"] = stats.insertions;
+        response["evictions"] = stats.evictions;
+        response["bytes"] = stats.bytes;
+        response["entries"] = stats.entries;
+        
+        return response;
     });
     
     // Add a default route
@@ -157,6 +485,12 @@ int main(int argc, char* argv[]) {
                "<ul>"
                "<li>GET /api/compress - Run compression on simulated IoT data</li>"
                "<li>POST /api/compress/custom - Run compression on user-provided data</li>"
+               "<li>GET /api/cache/stats - Result cache hit/miss counters</li>"
+               "<li>POST /api/ingest - Queue a device frame for batched compression</li>"
+               "<li>GET /api/batch/stats - Batching counters</li>"
+               "<li>GET /api/batch/latest - A device's most recent batch, decoded</li>"
+               "<li>POST /api/telemetry - Append a device sample</li>"
+               "<li>GET /api/telemetry/query - Aggregate a device's samples over a time range</li>"
                "</ul>"
                "</body></html>";
     });
@@ -165,5 +499,8 @@ int main(int argc, char* argv[]) {
     std::cout << "Server starting on port " << port << std::endl;
     app.port(port).multithreaded().run();
     
+    schedulerRunning = false;
+    schedulerThread.join();
+    
     return 0;
 }